@@ -18,28 +18,49 @@
 
 #include "Box2D/Collision/b2BroadPhase.h"
 
-b2BroadPhase::b2BroadPhase()
+#ifdef b2_useSSE2
+#include <emmintrin.h>
+#endif
+
+b2BroadPhase::b2BroadPhase(b2Allocator* allocator)
+	: m_allocator(allocator ? allocator : b2GetHeapAllocator()), m_tree(m_allocator)
 {
 	m_proxyCount = 0;
 
+	m_proxyListCapacity = b2_smallWorldProxyCount;
+	m_proxyList = (int32*)m_allocator->Allocate(m_proxyListCapacity * sizeof(int32));
+
 	m_pairCapacity = 16;
 	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	m_pairBuffer = (b2Pair*)m_allocator->Allocate(m_pairCapacity * sizeof(b2Pair));
 
 	m_moveCapacity = 16;
 	m_moveCount = 0;
-	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	m_moveBuffer = (int32*)m_allocator->Allocate(m_moveCapacity * sizeof(int32));
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
+	m_allocator->Free(m_moveBuffer);
+	m_allocator->Free(m_pairBuffer);
+	m_allocator->Free(m_proxyList);
 }
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
 	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+
+	// Grow the proxy list as needed.
+	if (m_proxyCount == m_proxyListCapacity)
+	{
+		int32* oldList = m_proxyList;
+		m_proxyListCapacity *= 2;
+		m_proxyList = (int32*)m_allocator->Allocate(m_proxyListCapacity * sizeof(int32));
+		memcpy(m_proxyList, oldList, m_proxyCount * sizeof(int32));
+		m_allocator->Free(oldList);
+	}
+	m_proxyList[m_proxyCount] = proxyId;
+
 	++m_proxyCount;
 	BufferMove(proxyId);
 	return proxyId;
@@ -48,6 +69,17 @@ int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
+
+	// Remove from the proxy list (order does not matter).
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		if (m_proxyList[i] == proxyId)
+		{
+			m_proxyList[i] = m_proxyList[m_proxyCount - 1];
+			break;
+		}
+	}
+
 	--m_proxyCount;
 	m_tree.DestroyProxy(proxyId);
 }
@@ -72,9 +104,9 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	{
 		int32* oldBuffer = m_moveBuffer;
 		m_moveCapacity *= 2;
-		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		m_moveBuffer = (int32*)m_allocator->Allocate(m_moveCapacity * sizeof(int32));
 		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
-		b2Free(oldBuffer);
+		m_allocator->Free(oldBuffer);
 	}
 
 	m_moveBuffer[m_moveCount] = proxyId;
@@ -101,19 +133,110 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		return true;
 	}
 
+	AddPairToBuffer(proxyId, m_queryProxyId);
+
+	return true;
+}
+
+void b2BroadPhase::AddPairToBuffer(int32 proxyIdA, int32 proxyIdB)
+{
 	// Grow the pair buffer as needed.
 	if (m_pairCount == m_pairCapacity)
 	{
 		b2Pair* oldBuffer = m_pairBuffer;
 		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+		m_pairBuffer = (b2Pair*)m_allocator->Allocate(m_pairCapacity * sizeof(b2Pair));
 		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-		b2Free(oldBuffer);
+		m_allocator->Free(oldBuffer);
 	}
 
-	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
-	m_pairBuffer[m_pairCount].proxyIdB = b2Max(proxyId, m_queryProxyId);
+	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyIdA, proxyIdB);
+	m_pairBuffer[m_pairCount].proxyIdB = b2Max(proxyIdA, proxyIdB);
 	++m_pairCount;
+}
 
-	return true;
+// Same test as b2TestOverlap with fat AABBs of all proxies in SoA layout,
+// four proxies at a time.
+void b2BroadPhase::QueryAllPairs()
+{
+	const int32 kMaxCount = (b2_smallWorldProxyCount + 3) & ~3;
+	b2Assert(m_proxyCount <= kMaxCount);
+
+	// Gather fat AABBs. Padding lanes never overlap.
+	float32 lowerX[kMaxCount], lowerY[kMaxCount], upperX[kMaxCount], upperY[kMaxCount];
+	int32 count = (m_proxyCount + 3) & ~3;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (i < m_proxyCount)
+		{
+			const b2AABB& aabb = m_tree.GetFatAABB(m_proxyList[i]);
+			lowerX[i] = aabb.lowerBound.x;
+			lowerY[i] = aabb.lowerBound.y;
+			upperX[i] = aabb.upperBound.x;
+			upperY[i] = aabb.upperBound.y;
+		}
+		else
+		{
+			lowerX[i] = b2_maxFloat;
+			lowerY[i] = b2_maxFloat;
+			upperX[i] = -b2_maxFloat;
+			upperY[i] = -b2_maxFloat;
+		}
+	}
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 queryProxyId = m_moveBuffer[i];
+		if (queryProxyId == e_nullProxy)
+		{
+			continue;
+		}
+
+		const b2AABB& fatAABB = m_tree.GetFatAABB(queryProxyId);
+
+#ifdef b2_useSSE2
+		const __m128 qLowerX = _mm_set1_ps(fatAABB.lowerBound.x);
+		const __m128 qLowerY = _mm_set1_ps(fatAABB.lowerBound.y);
+		const __m128 qUpperX = _mm_set1_ps(fatAABB.upperBound.x);
+		const __m128 qUpperY = _mm_set1_ps(fatAABB.upperBound.y);
+		for (int32 j = 0; j < count; j += 4)
+		{
+			__m128 overlap = _mm_and_ps(
+				_mm_and_ps(
+					_mm_cmple_ps(_mm_loadu_ps(lowerX + j), qUpperX),
+					_mm_cmple_ps(_mm_loadu_ps(lowerY + j), qUpperY)),
+				_mm_and_ps(
+					_mm_cmple_ps(qLowerX, _mm_loadu_ps(upperX + j)),
+					_mm_cmple_ps(qLowerY, _mm_loadu_ps(upperY + j))));
+			int32 mask = _mm_movemask_ps(overlap);
+			while (mask)
+			{
+				int32 k = j;
+				int32 bit = mask & -mask;
+				while (bit >>= 1)
+				{
+					++k;
+				}
+				mask &= mask - 1;
+
+				// A proxy cannot form a pair with itself.
+				if (m_proxyList[k] != queryProxyId)
+				{
+					AddPairToBuffer(m_proxyList[k], queryProxyId);
+				}
+			}
+		}
+#else
+		for (int32 j = 0; j < m_proxyCount; ++j)
+		{
+			bool overlap =
+				lowerX[j] <= fatAABB.upperBound.x && lowerY[j] <= fatAABB.upperBound.y &&
+				fatAABB.lowerBound.x <= upperX[j] && fatAABB.lowerBound.y <= upperY[j];
+			if (overlap && m_proxyList[j] != queryProxyId)
+			{
+				AddPairToBuffer(m_proxyList[j], queryProxyId);
+			}
+		}
+#endif
+	}
 }
@@ -42,7 +42,8 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// Buffers are taken from allocator (nullptr: b2Alloc/b2Free).
+	b2BroadPhase(b2Allocator* allocator = nullptr);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
@@ -113,10 +114,21 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	void AddPairToBuffer(int32 proxyIdA, int32 proxyIdB);
+
+	// Find pairs of moving proxies by testing all proxies (small world).
+	void QueryAllPairs();
+
+	b2Allocator* m_allocator;
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
 
+	// Ids of all proxies, used to test all pairs in a small world.
+	int32* m_proxyList;
+	int32 m_proxyListCapacity;
+
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
 	int32 m_moveCount;
@@ -187,21 +199,29 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	// Reset pair buffer
 	m_pairCount = 0;
 
-	// Perform tree queries for all moving proxies.
-	for (int32 i = 0; i < m_moveCount; ++i)
+	if (m_proxyCount <= b2_smallWorldProxyCount)
+	{
+		// Brute force is cheaper than tree queries for a few proxies.
+		QueryAllPairs();
+	}
+	else
 	{
-		m_queryProxyId = m_moveBuffer[i];
-		if (m_queryProxyId == e_nullProxy)
+		// Perform tree queries for all moving proxies.
+		for (int32 i = 0; i < m_moveCount; ++i)
 		{
-			continue;
-		}
+			m_queryProxyId = m_moveBuffer[i];
+			if (m_queryProxyId == e_nullProxy)
+			{
+				continue;
+			}
 
-		// We have to query the tree with the fat AABB so that
-		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+			// We have to query the tree with the fat AABB so that
+			// we don't fail to create a pair that may touch later.
+			const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
 
-		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
+			// Query tree, create pairs and add them pair buffer.
+			m_tree.Query(this, fatAABB);
+		}
 	}
 
 	// Reset move buffer
@@ -23,7 +23,7 @@
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
-int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 {
@@ -441,12 +441,67 @@ void b2Simplex::Solve3()
 	m_count = 3;
 }
 
+// Move the witness points to the surfaces of the shapes.
+static void b2ApplyRadii(b2DistanceOutput* output, const b2DistanceProxy* proxyA, const b2DistanceProxy* proxyB)
+{
+	float32 rA = proxyA->m_radius;
+	float32 rB = proxyB->m_radius;
+
+	if (output->distance > rA + rB && output->distance > b2_epsilon)
+	{
+		// Shapes are still no overlapped.
+		// Move the witness points to the outer surface.
+		output->distance -= rA + rB;
+		b2Vec2 normal = output->pointB - output->pointA;
+		normal.Normalize();
+		output->pointA += rA * normal;
+		output->pointB -= rB * normal;
+	}
+	else
+	{
+		// Shapes are overlapped when radii are considered.
+		// Move the witness points to the middle.
+		b2Vec2 p = 0.5f * (output->pointA + output->pointB);
+		output->pointA = p;
+		output->pointB = p;
+		output->distance = 0.0f;
+	}
+}
+
+// Two circles: the simplex is always the pair of centers, so GJK is not needed.
+static void b2DistanceCircles(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input)
+{
+	output->pointA = b2Mul(input->transformA, input->proxyA.m_vertices[0]);
+	output->pointB = b2Mul(input->transformB, input->proxyB.m_vertices[0]);
+	output->distance = b2Distance(output->pointA, output->pointB);
+	output->iterations = 0;
+
+	cache->metric = 0.0f;
+	cache->count = 1;
+	cache->indexA[0] = 0;
+	cache->indexB[0] = 0;
+
+	if (input->useRadii)
+	{
+		b2ApplyRadii(output, &input->proxyA, &input->proxyB);
+	}
+}
+
 void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
 	++b2_gjkCalls;
 
+	// Dispatch by shape type (only circles have a single vertex).
+	if (input->proxyA.m_count == 1 && input->proxyB.m_count == 1)
+	{
+		b2DistanceCircles(output, cache, input);
+		return;
+	}
+
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
 
@@ -563,27 +618,6 @@ void b2Distance(b2DistanceOutput* output,
 	// Apply radii if requested.
 	if (input->useRadii)
 	{
-		float32 rA = proxyA->m_radius;
-		float32 rB = proxyB->m_radius;
-
-		if (output->distance > rA + rB && output->distance > b2_epsilon)
-		{
-			// Shapes are still no overlapped.
-			// Move the witness points to the outer surface.
-			output->distance -= rA + rB;
-			b2Vec2 normal = output->pointB - output->pointA;
-			normal.Normalize();
-			output->pointA += rA * normal;
-			output->pointB -= rB * normal;
-		}
-		else
-		{
-			// Shapes are overlapped when radii are considered.
-			// Move the witness points to the middle.
-			b2Vec2 p = 0.5f * (output->pointA + output->pointB);
-			output->pointA = p;
-			output->pointB = p;
-			output->distance = 0.0f;
-		}
+		b2ApplyRadii(output, proxyA, proxyB);
 	}
 }
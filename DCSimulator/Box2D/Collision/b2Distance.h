@@ -86,10 +86,14 @@ struct b2DistanceOutput
 /// Compute the closest points between two shapes. Supports any combination of:
 /// b2CircleShape, b2PolygonShape, b2EdgeShape. The simplex cache is input/output.
 /// On the first call set b2SimplexCache.count to zero.
+/// Two circles are handled directly without GJK iterations.
 void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// Profiling counters of b2Distance (per thread).
+extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+
 
 //////////////////////////////////////////////////////////////////////////
 
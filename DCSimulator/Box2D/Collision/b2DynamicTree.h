@@ -62,7 +62,8 @@ class b2DynamicTree
 {
 public:
 	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// The pool is taken from allocator (nullptr: b2Alloc/b2Free).
+	b2DynamicTree(b2Allocator* allocator = nullptr);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -141,6 +142,8 @@ private:
 
 	int32 m_root;
 
+	b2Allocator* m_allocator;
+
 	b2TreeNode* m_nodes;
 	int32 m_nodeCount;
 	int32 m_nodeCapacity;
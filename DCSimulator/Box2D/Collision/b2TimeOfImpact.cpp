@@ -26,7 +26,7 @@
 #include <stdio.h>
 
 float32 b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+thread_local int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
 int32 b2_toiRootIters, b2_toiMaxRootIters;
 
 //
@@ -249,14 +249,86 @@ struct b2SeparationFunction
 	b2Vec2 m_axis;
 };
 
+// Is the circle of the proxy on the center of mass? Then rotation does not move it
+// and the circle moves linearly within the sweep.
+static inline bool b2IsCenteredCircle(const b2DistanceProxy* proxy, const b2Sweep& sweep)
+{
+	return proxy->m_count == 1 && proxy->m_vertices[0] == sweep.localCenter;
+}
+
+// CCD of two centered circles. The distance between the centers is |d0 + t * dv|,
+// so the time the cores reach the target separation is a root of a quadratic.
+static void b2TimeOfImpactCircles(b2TOIOutput* output, const b2TOIInput* input)
+{
+	const b2Sweep& sweepA = input->sweepA;
+	const b2Sweep& sweepB = input->sweepB;
+	float32 tMax = input->tMax;
+
+	float32 totalRadius = input->proxyA.m_radius + input->proxyB.m_radius;
+	float32 target = b2Max(b2_linearSlop, totalRadius - 3.0f * b2_linearSlop);
+	float32 tolerance = 0.25f * b2_linearSlop;
+
+	b2Vec2 d0 = sweepB.c0 - sweepA.c0;
+	b2Vec2 dv = (sweepB.c - sweepB.c0) - (sweepA.c - sweepA.c0);
+
+	float32 distance = d0.Length();
+	if (distance <= 0.0f)
+	{
+		output->state = b2TOIOutput::e_overlapped;
+		output->t = 0.0f;
+		return;
+	}
+
+	if (distance < target + tolerance)
+	{
+		output->state = b2TOIOutput::e_touching;
+		output->t = 0.0f;
+		return;
+	}
+
+	// |d0 + t * dv|^2 = target^2  =>  a * t^2 + 2 * b * t + c = 0 (c > 0)
+	float32 a = b2Dot(dv, dv);
+	float32 b = b2Dot(d0, dv);
+	float32 c = b2Dot(d0, d0) - target * target;
+	float32 disc = b * b - a * c;
+
+	// Moving apart or passing by?
+	if (b >= 0.0f || disc < 0.0f)
+	{
+		output->state = b2TOIOutput::e_separated;
+		output->t = tMax;
+		return;
+	}
+
+	// Smaller root in the stable form
+	float32 t = c / (-b + b2Sqrt(disc));
+	if (t >= tMax)
+	{
+		output->state = b2TOIOutput::e_separated;
+		output->t = tMax;
+		return;
+	}
+
+	output->state = b2TOIOutput::e_touching;
+	output->t = t;
+}
+
 // CCD via the local separating axis method. This seeks progression
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	b2Timer timer;
-
 	++b2_toiCalls;
 
+	// Dispatch by shape type
+	if (b2IsCenteredCircle(&input->proxyA, input->sweepA) &&
+		b2IsCenteredCircle(&input->proxyB, input->sweepB))
+	{
+		b2TimeOfImpactCircles(output, input);
+		return;
+	}
+
+	b2Timer timer;
+
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
 
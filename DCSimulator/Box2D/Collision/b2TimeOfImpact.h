@@ -53,6 +53,10 @@ struct b2TOIOutput
 /// non-tunneling collision. If you change the time interval, you should call this function
 /// again.
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
+/// Two circles on the centers of mass are solved analytically without iterations.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Profiling counters of b2TimeOfImpact (per thread).
+extern thread_local int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+
 #endif
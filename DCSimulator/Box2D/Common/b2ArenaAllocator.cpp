@@ -0,0 +1,83 @@
+// Arena allocator for worlds which are released at once (not part of Box2D 2.3.2)
+
+#include "Box2D/Common/b2ArenaAllocator.h"
+#include "Box2D/Common/b2Math.h"
+
+// Alignment of allocations (same as malloc)
+static const int32 b2_arenaAlignment = 16;
+static const int32 b2_arenaHeaderSize = (sizeof(void*) + sizeof(int32) + b2_arenaAlignment - 1) & ~(b2_arenaAlignment - 1);
+
+b2ArenaAllocator::b2ArenaAllocator(int32 blockSize)
+{
+	m_blocks = nullptr;
+	m_data = nullptr;
+	m_index = 0;
+	m_size = 0;
+
+	m_blockSize = blockSize;
+	m_allocation = 0;
+	m_maxAllocation = 0;
+}
+
+b2ArenaAllocator::~b2ArenaAllocator()
+{
+	Block* block = m_blocks;
+	while (block)
+	{
+		Block* next = block->next;
+		b2Free(block);
+		block = next;
+	}
+}
+
+void b2ArenaAllocator::AddBlock(int32 size)
+{
+	Block* block = (Block*)b2Alloc(b2_arenaHeaderSize + size);
+	block->next = m_blocks;
+	block->size = size;
+	m_blocks = block;
+
+	m_data = (char*)block + b2_arenaHeaderSize;
+	m_index = 0;
+	m_size = size;
+}
+
+void* b2ArenaAllocator::Allocate(int32 size)
+{
+	size = (size + b2_arenaAlignment - 1) & ~(b2_arenaAlignment - 1);
+
+	if (m_index + size > m_size)
+	{
+		AddBlock(b2Max(size, m_blockSize));
+	}
+
+	void* mem = m_data + m_index;
+	m_index += size;
+
+	m_allocation += size;
+	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+
+	return mem;
+}
+
+void b2ArenaAllocator::Reset()
+{
+	if (m_blocks && m_blocks->next)
+	{
+		// Merge the blocks so that the next world fits in one.
+		int32 size = 0;
+		Block* block = m_blocks;
+		while (block)
+		{
+			Block* next = block->next;
+			size += block->size;
+			b2Free(block);
+			block = next;
+		}
+		m_blocks = nullptr;
+		AddBlock(size);
+	}
+
+	m_index = 0;
+	m_allocation = 0;
+}
@@ -0,0 +1,54 @@
+// Arena allocator for worlds which are released at once (not part of Box2D 2.3.2)
+
+#ifndef B2_ARENA_ALLOCATOR_H
+#define B2_ARENA_ALLOCATOR_H
+
+#include "Box2D/Common/b2Settings.h"
+
+const int32 b2_arenaBlockSize = 64 * 1024;	// 64k
+
+/// Monotonic allocator for a world which is thrown away as a whole.
+/// Free does nothing and Reset releases everything in O(1), so the world need not
+/// destroy its bodies one by one. The memory is kept for the next world.
+/// A world on an arena must not use b2ChainShape (its vertices use b2Alloc).
+class b2ArenaAllocator : public b2Allocator
+{
+public:
+	b2ArenaAllocator(int32 blockSize = b2_arenaBlockSize);
+	~b2ArenaAllocator();
+
+	void* Allocate(int32 size) override;
+	void Free(void* mem) override { B2_NOT_USED(mem); }
+	bool IsArena() const override { return true; }
+
+	/// Release all allocations. Destroy (or abandon) the worlds on this arena before.
+	/// If the last worlds needed more than one block, the blocks are merged into one.
+	void Reset();
+
+	/// Get the number of bytes allocated since the last reset.
+	int32 GetAllocation() const { return m_allocation; }
+
+	/// Get the largest number of bytes allocated between resets.
+	int32 GetMaxAllocation() const { return m_maxAllocation; }
+
+private:
+
+	struct Block
+	{
+		Block* next;
+		int32 size;		// bytes after the header
+	};
+
+	void AddBlock(int32 size);
+
+	Block* m_blocks;	// current block first
+	char* m_data;
+	int32 m_index;
+	int32 m_size;
+
+	int32 m_blockSize;
+	int32 m_allocation;
+	int32 m_maxAllocation;
+};
+
+#endif
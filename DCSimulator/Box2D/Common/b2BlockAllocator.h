@@ -35,19 +35,25 @@ struct b2Chunk;
 class b2BlockAllocator
 {
 public:
-	b2BlockAllocator();
+	/// Chunks and large blocks are taken from allocator (nullptr: b2Alloc/b2Free).
+	b2BlockAllocator(b2Allocator* allocator = nullptr);
 	~b2BlockAllocator();
 
-	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// Allocate memory. This will use the allocator if the size is larger than b2_maxBlockSize.
 	void* Allocate(int32 size);
 
-	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
+	/// Free memory. This will use the allocator if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
 	void Clear();
 
+	/// Get the number of chunks (b2_chunkSize each) taken from the allocator.
+	int32 GetChunkCount() const { return m_chunkCount; }
+
 private:
 
+	b2Allocator* m_allocator;
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
@@ -23,15 +23,62 @@
 
 b2Version b2_version = {2, 3, 2};
 
+thread_local b2AllocStats b2_allocStats;
+
+// Size of the header of b2Alloc blocks (keeps the alignment of malloc)
+static const int32 b2_allocHeaderSize = 16;
+
 // Memory allocators. Modify these to use your own allocator.
+// The size is kept in front of each block for the counters.
 void* b2Alloc(int32 size)
 {
-	return malloc(size);
+	char* block = (char*)malloc(b2_allocHeaderSize + size);
+	*(int32*)block = size;
+
+	b2AllocStats& stats = b2_allocStats;
+	++stats.allocCount;
+	stats.allocBytes += size;
+	stats.bytes += size;
+	stats.maxBytes = stats.bytes > stats.maxBytes ? stats.bytes : stats.maxBytes;
+
+	return block + b2_allocHeaderSize;
 }
 
 void b2Free(void* mem)
 {
-	free(mem);
+	if (mem == nullptr)
+	{
+		return;
+	}
+
+	char* block = (char*)mem - b2_allocHeaderSize;
+
+	b2AllocStats& stats = b2_allocStats;
+	++stats.freeCount;
+	stats.bytes -= *(int32*)block;
+
+	free(block);
+}
+
+// Allocator of worlds created without one
+class b2HeapAllocator : public b2Allocator
+{
+public:
+	void* Allocate(int32 size) override
+	{
+		return b2Alloc(size);
+	}
+
+	void Free(void* mem) override
+	{
+		b2Free(mem);
+	}
+};
+
+b2Allocator* b2GetHeapAllocator()
+{
+	static b2HeapAllocator s_heapAllocator;
+	return &s_heapAllocator;
 }
 
 // You can modify this to use your logging facility.
@@ -83,6 +83,35 @@ typedef double float64;
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps			8
 
+/// The broad-phase tests all proxy pairs with SIMD instead of querying the dynamic
+/// tree when there are at most this many proxies (e.g. 16 stones of curling).
+/// Above this count the dynamic tree is used.
+#define b2_smallWorldProxyCount	16
+
+/// Number of fixtures which can be registered in the contact pair table
+/// (see b2World::SetPairTable). Do not set this above 32.
+#define b2_pairTableSlots		16
+
+/// Velocity iterations stop when no impulse changes more than this in an iteration
+/// (see b2World::SetAdaptiveVelocityIterations). Usually in kg * m / s.
+#define b2_velocityIterationTolerance	1.0e-5f
+
+/// Minimum number of velocity iterations in the adaptive mode.
+#define b2_minVelocityIterations	1
+
+/// Islands with at least this many contacts use the wide contact solver, which
+/// colors the contact graph and solves independent contacts in SIMD lanes.
+#define b2_wideSolverMinContacts	4
+
+/// Number of colors of the contact graph used by the wide contact solver.
+/// Contacts which can't be colored are solved sequentially. Do not set this above 32.
+#define b2_graphColorCount		8
+
+/// SSE2 is used by the small world broad-phase and the wide contact solver if available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define b2_useSSE2
+#endif
+
 
 // Dynamics
 
@@ -137,6 +166,42 @@ void* b2Alloc(int32 size);
 /// If you implement b2Alloc, you should also implement this function.
 void b2Free(void* mem);
 
+/// Counters of heap allocations by b2Alloc/b2Free (per thread). Memory freed in
+/// another thread than it was allocated is counted there.
+struct b2AllocStats
+{
+	int32 allocCount;		///< number of b2Alloc calls
+	int32 freeCount;		///< number of b2Free calls
+	uint32 allocBytes;		///< bytes allocated by b2Alloc (wraps around, use differences)
+	int32 bytes;			///< bytes in use
+	int32 maxBytes;			///< high-water mark of bytes in use (may be reset to bytes)
+};
+
+/// Heap counters of this thread.
+extern thread_local b2AllocStats b2_allocStats;
+
+/// Allocator interface of a world. Implement this to route the memory of a world
+/// (block allocator chunks, large stack allocations, broad-phase and island arrays)
+/// to your own pools. The default allocator uses b2Alloc/b2Free.
+class b2Allocator
+{
+public:
+	virtual ~b2Allocator() {}
+
+	/// Allocate memory aligned as b2Alloc.
+	virtual void* Allocate(int32 size) = 0;
+
+	/// Free memory returned by Allocate.
+	virtual void Free(void* mem) = 0;
+
+	/// Return true if the memory is released at once by the owner and Free does nothing.
+	/// A world on such an allocator is released without destroying its objects.
+	virtual bool IsArena() const { return false; }
+};
+
+/// Get the allocator using b2Alloc/b2Free.
+b2Allocator* b2GetHeapAllocator();
+
 /// Logging function.
 void b2Log(const char* string, ...);
 
@@ -19,11 +19,16 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Math.h"
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(b2Allocator* allocator)
 {
+	m_allocator = allocator ? allocator : b2GetHeapAllocator();
+	m_data = nullptr;
+	m_size = b2_stackSize;
+	m_ownData = true;
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_fallbackCount = 0;
 	m_entryCount = 0;
 }
 
@@ -31,18 +36,51 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	ReleaseData();
+}
+
+void b2StackAllocator::ReleaseData()
+{
+	if (m_ownData && m_data)
+	{
+		m_allocator->Free(m_data);
+	}
+	m_data = nullptr;
+}
+
+void b2StackAllocator::SetSize(int32 size)
+{
+	b2Assert(m_entryCount == 0);
+	ReleaseData();
+	m_size = size;
+	m_ownData = true;
+}
+
+void b2StackAllocator::SetBuffer(void* data, int32 size)
+{
+	b2Assert(m_entryCount == 0);
+	ReleaseData();
+	m_data = (char*)data;
+	m_size = size;
+	m_ownData = false;
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
+	if (m_data == nullptr && m_ownData && m_size > 0)
+	{
+		m_data = (char*)m_allocator->Allocate(m_size);
+	}
+
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_size)
 	{
-		entry->data = (char*)b2Alloc(size);
+		entry->data = (char*)m_allocator->Allocate(size);
 		entry->usedMalloc = true;
+		++m_fallbackCount;
 	}
 	else
 	{
@@ -65,7 +103,7 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(p == entry->data);
 	if (entry->usedMalloc)
 	{
-		b2Free(p);
+		m_allocator->Free(p);
 	}
 	else
 	{
@@ -74,9 +112,21 @@ void b2StackAllocator::Free(void* p)
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	// Grow the owned memory so that the next steps fit.
+	if (m_entryCount == 0 && m_ownData && m_maxAllocation > m_size)
+	{
+		ReleaseData();
+		m_size = m_maxAllocation;
+	}
+
 	p = nullptr;
 }
 
+int32 b2StackAllocator::GetSize() const
+{
+	return m_size;
+}
+
 int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
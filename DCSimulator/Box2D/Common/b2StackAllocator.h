@@ -21,7 +21,7 @@
 
 #include "Box2D/Common/b2Settings.h"
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// 100k (default size)
 const int32 b2_maxStackEntries = 32;
 
 struct b2StackEntry
@@ -34,24 +34,49 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// The stack memory is either owned (taken from the allocator on first use and grown to
+// the high-water mark once the stack is empty) or provided by the caller (fixed size).
+// Allocations which do not fit go to the allocator.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	/// Memory is taken from allocator (nullptr: b2Alloc/b2Free).
+	b2StackAllocator(b2Allocator* allocator = nullptr);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Set the size of the owned stack memory. Call while the stack is empty.
+	void SetSize(int32 size);
+
+	/// Use memory of the caller (e.g. scratch memory shared by the worlds of a thread).
+	/// It is not grown or freed. Call while the stack is empty.
+	void SetBuffer(void* data, int32 size);
+
+	/// Get the size of the stack memory.
+	int32 GetSize() const;
+
+	/// Get the high-water mark of allocations in bytes.
 	int32 GetMaxAllocation() const;
 
+	/// Get the number of allocations which did not fit the stack memory.
+	int32 GetFallbackCount() const { return m_fallbackCount; }
+
 private:
 
-	char m_data[b2_stackSize];
+	void ReleaseData();
+
+	b2Allocator* m_allocator;
+
+	char* m_data;
+	int32 m_size;
+	bool m_ownData;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_fallbackCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -29,6 +29,7 @@
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Collision/b2TimeOfImpact.h"
 #include "Box2D/Collision/Shapes/b2Shape.h"
+#include "Box2D/Collision/Shapes/b2CircleShape.h"
 #include "Box2D/Common/b2BlockAllocator.h"
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
@@ -125,14 +126,23 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 
 b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 {
-	m_flags = e_enabledFlag;
-
 	m_fixtureA = fA;
 	m_fixtureB = fB;
 
 	m_indexA = indexA;
 	m_indexB = indexB;
 
+	Reset();
+}
+
+void b2Contact::Reset()
+{
+	m_flags = e_enabledFlag;
+	if (m_fixtureA->GetType() == b2Shape::e_circle && m_fixtureB->GetType() == b2Shape::e_circle)
+	{
+		m_flags |= e_circlesFlag;
+	}
+
 	m_manifold.pointCount = 0;
 
 	m_prev = nullptr;
@@ -189,7 +199,17 @@ void b2Contact::Update(b2ContactListener* listener)
 	}
 	else
 	{
-		Evaluate(&m_manifold, xfA, xfB);
+		if (m_flags & e_circlesFlag)
+		{
+			// Same as b2CircleContact::Evaluate without the virtual call.
+			b2CollideCircles(&m_manifold,
+				(b2CircleShape*)m_fixtureA->GetShape(), xfA,
+				(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+		}
+		else
+		{
+			Evaluate(&m_manifold, xfA, xfB);
+		}
 		touching = m_manifold.pointCount > 0;
 
 		// Match old contact ids to new contact ids and copy the
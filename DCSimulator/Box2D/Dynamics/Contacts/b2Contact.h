@@ -170,7 +170,13 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// This contact is owned by the contact pair table
+		e_pairTableFlag		= 0x0040,
+
+		// Both shapes are circles, so the narrow-phase calls b2CollideCircles directly
+		e_circlesFlag		= 0x0080
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
@@ -187,6 +193,10 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
+	/// Reset to the state just after construction, keeping the fixtures.
+	/// Used to reuse a contact of the pair table.
+	void Reset();
+
 	void Update(b2ContactListener* listener);
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
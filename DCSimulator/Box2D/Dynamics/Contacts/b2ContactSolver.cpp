@@ -24,6 +24,12 @@
 #include "Box2D/Dynamics/b2World.h"
 #include "Box2D/Common/b2StackAllocator.h"
 
+#include <string.h>
+
+#ifdef b2_useSSE2
+#include <emmintrin.h>
+#endif
+
 // Solver debugging is normally disabled because the block solver sometimes has to deal with a poorly conditioned effective mass matrix.
 #define B2_DEBUG_SOLVER 0
 
@@ -42,6 +48,31 @@ struct b2ContactPositionConstraint
 	b2Manifold::Type type;
 	float32 radiusA, radiusB;
 	int32 pointCount;
+
+	// Circles at the centers of mass: the manifold points are the body
+	// positions, so the rotations are not needed.
+	bool centered;
+};
+
+// Single point constraints of one color in SoA layout, one constraint per lane.
+struct b2ContactConstraintWide
+{
+	int32 constraintIndex[b2_solverLanes];
+	int32 indexA[b2_solverLanes];
+	int32 indexB[b2_solverLanes];
+	float32 invMassA[b2_solverLanes], invMassB[b2_solverLanes];
+	float32 invIA[b2_solverLanes], invIB[b2_solverLanes];
+	float32 normalX[b2_solverLanes], normalY[b2_solverLanes];
+	float32 rAX[b2_solverLanes], rAY[b2_solverLanes];
+	float32 rBX[b2_solverLanes], rBY[b2_solverLanes];
+	float32 normalMass[b2_solverLanes];
+	float32 tangentMass[b2_solverLanes];
+	float32 velocityBias[b2_solverLanes];
+	float32 normalImpulse[b2_solverLanes];
+	float32 tangentImpulse[b2_solverLanes];
+	float32 friction[b2_solverLanes];
+	float32 tangentSpeed[b2_solverLanes];
+	int32 count;
 };
 
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
@@ -85,8 +116,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		vc->invIB = bodyB->m_invI;
 		vc->contactIndex = i;
 		vc->pointCount = pointCount;
-		vc->K.SetZero();
-		vc->normalMass.SetZero();
+		if (pointCount == 2)
+		{
+			// Block solver
+			vc->K.SetZero();
+			vc->normalMass.SetZero();
+		}
 
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 		pc->indexA = bodyA->m_islandIndex;
@@ -128,11 +163,34 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 			pc->localPoints[j] = cp->localPoint;
 		}
+
+		pc->centered = pc->type == b2Manifold::e_circles &&
+			pc->localPoint.x == 0.0f && pc->localPoint.y == 0.0f &&
+			pc->localPoints[0].x == 0.0f && pc->localPoints[0].y == 0.0f &&
+			pc->localCenterA.x == 0.0f && pc->localCenterA.y == 0.0f &&
+			pc->localCenterB.x == 0.0f && pc->localCenterB.y == 0.0f;
+	}
+
+	m_wideConstraints = nullptr;
+	m_wideCount = 0;
+	m_scalarIndices = nullptr;
+	m_scalarCount = m_count;
+
+#ifdef b2_useSSE2
+	if (m_count >= b2_wideSolverMinContacts)
+	{
+		BuildWideConstraints();
 	}
+#endif
 }
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_scalarIndices)
+	{
+		m_allocator->Free(m_scalarIndices);
+		m_allocator->Free(m_wideConstraints);
+	}
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -171,6 +229,53 @@ void b2ContactSolver::InitializeVelocityConstraints()
 
 		b2Assert(manifold->pointCount > 0);
 
+		if (pc->type == b2Manifold::e_circles)
+		{
+			// Single point circle contact: same as b2WorldManifold::Initialize for
+			// e_circles, without the block solver.
+			b2Vec2 pointA = cA;
+			b2Vec2 pointB = cB;
+			if (pc->centered == false)
+			{
+				b2Rot qA(aA), qB(aB);
+				pointA = b2Mul(qA, pc->localPoint) + (cA - b2Mul(qA, localCenterA));
+				pointB = b2Mul(qB, pc->localPoints[0]) + (cB - b2Mul(qB, localCenterB));
+			}
+
+			b2Vec2 normal(1.0f, 0.0f);
+			if (b2DistanceSquared(pointA, pointB) > b2_epsilon * b2_epsilon)
+			{
+				normal = pointB - pointA;
+				normal.Normalize();
+			}
+			b2Vec2 point = 0.5f * ((pointA + radiusA * normal) + (pointB - radiusB * normal));
+
+			b2VelocityConstraintPoint* vcp = vc->points + 0;
+			vc->normal = normal;
+			vcp->rA = point - cA;
+			vcp->rB = point - cB;
+
+			float32 rnA = b2Cross(vcp->rA, normal);
+			float32 rnB = b2Cross(vcp->rB, normal);
+			float32 kNormal = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+			vcp->normalMass = kNormal > 0.0f ? 1.0f / kNormal : 0.0f;
+
+			b2Vec2 tangent = b2Cross(normal, 1.0f);
+			float32 rtA = b2Cross(vcp->rA, tangent);
+			float32 rtB = b2Cross(vcp->rB, tangent);
+			float32 kTangent = mA + mB + iA * rtA * rtA + iB * rtB * rtB;
+			vcp->tangentMass = kTangent > 0.0f ? 1.0f / kTangent : 0.0f;
+
+			// Setup a velocity bias for restitution.
+			vcp->velocityBias = 0.0f;
+			float32 vRel = b2Dot(normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
+			if (vRel < -b2_velocityThreshold)
+			{
+				vcp->velocityBias = -vc->restitution * vRel;
+			}
+			continue;
+		}
+
 		b2Transform xfA, xfB;
 		xfA.q.Set(aA);
 		xfB.q.Set(aB);
@@ -247,6 +352,11 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+	if (m_wideCount > 0)
+	{
+		PrepareWideConstraints();
+	}
 }
 
 void b2ContactSolver::WarmStart()
@@ -289,10 +399,18 @@ void b2ContactSolver::WarmStart()
 	}
 }
 
-void b2ContactSolver::SolveVelocityConstraints()
+float32 b2ContactSolver::SolveVelocityConstraints()
 {
-	for (int32 i = 0; i < m_count; ++i)
+	float32 maxImpulse = 0.0f;
+
+	if (m_wideCount > 0)
+	{
+		maxImpulse = SolveWideVelocityConstraints();
+	}
+
+	for (int32 k = 0; k < m_scalarCount; ++k)
 	{
+		int32 i = m_scalarIndices ? m_scalarIndices[k] : k;
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 
 		int32 indexA = vc->indexA;
@@ -314,6 +432,49 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 		b2Assert(pointCount == 1 || pointCount == 2);
 
+		if (pointCount == 1)
+		{
+			// Single point (all circle contacts): no loops and no block solver.
+			b2VelocityConstraintPoint* vcp = vc->points + 0;
+
+			// Tangent constraint
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vt = b2Dot(dv, tangent) - vc->tangentSpeed;
+			float32 lambda = vcp->tangentMass * (-vt);
+			float32 maxFriction = friction * vcp->normalImpulse;
+			float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - vcp->tangentImpulse;
+			maxImpulse = b2Max(maxImpulse, b2Abs(lambda));
+			vcp->tangentImpulse = newImpulse;
+
+			b2Vec2 P = lambda * tangent;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+
+			// Normal constraint
+			dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
+			lambda = -vcp->normalMass * (vn - vcp->velocityBias);
+			newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			maxImpulse = b2Max(maxImpulse, b2Abs(lambda));
+			vcp->normalImpulse = newImpulse;
+
+			P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+			continue;
+		}
+
 		// Solve tangent constraints first because non-penetration is more important
 		// than friction.
 		for (int32 j = 0; j < pointCount; ++j)
@@ -331,6 +492,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 			float32 maxFriction = friction * vcp->normalImpulse;
 			float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
 			lambda = newImpulse - vcp->tangentImpulse;
+			maxImpulse = b2Max(maxImpulse, b2Abs(lambda));
 			vcp->tangentImpulse = newImpulse;
 
 			// Apply contact impulse
@@ -360,6 +522,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 				// b2Clamp the accumulated impulse
 				float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
 				lambda = newImpulse - vcp->normalImpulse;
+				maxImpulse = b2Max(maxImpulse, b2Abs(lambda));
 				vcp->normalImpulse = newImpulse;
 
 				// Apply contact impulse
@@ -447,6 +610,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 				{
 					// Get the incremental impulse
 					b2Vec2 d = x - a;
+					maxImpulse = b2Max(maxImpulse, b2Max(b2Abs(d.x), b2Abs(d.y)));
 
 					// Apply incremental impulse
 					b2Vec2 P1 = d.x * normal;
@@ -490,6 +654,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 				{
 					// Get the incremental impulse
 					b2Vec2 d = x - a;
+					maxImpulse = b2Max(maxImpulse, b2Max(b2Abs(d.x), b2Abs(d.y)));
 
 					// Apply incremental impulse
 					b2Vec2 P1 = d.x * normal;
@@ -532,6 +697,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 				{
 					// Resubstitute for the incremental impulse
 					b2Vec2 d = x - a;
+					maxImpulse = b2Max(maxImpulse, b2Max(b2Abs(d.x), b2Abs(d.y)));
 
 					// Apply incremental impulse
 					b2Vec2 P1 = d.x * normal;
@@ -572,6 +738,7 @@ void b2ContactSolver::SolveVelocityConstraints()
 				{
 					// Resubstitute for the incremental impulse
 					b2Vec2 d = x - a;
+					maxImpulse = b2Max(maxImpulse, b2Max(b2Abs(d.x), b2Abs(d.y)));
 
 					// Apply incremental impulse
 					b2Vec2 P1 = d.x * normal;
@@ -599,6 +766,8 @@ void b2ContactSolver::SolveVelocityConstraints()
 		m_velocities[indexB].v = vB;
 		m_velocities[indexB].w = wB;
 	}
+
+	return maxImpulse;
 }
 
 void b2ContactSolver::StoreImpulses()
@@ -662,6 +831,26 @@ struct b2PositionSolverManifold
 		}
 	}
 
+	// Initialize from the body positions. Centered circles skip the transforms.
+	void Initialize(b2ContactPositionConstraint* pc, b2Vec2 cA, float32 aA, b2Vec2 cB, float32 aB, int32 index)
+	{
+		if (pc->centered)
+		{
+			normal = cB - cA;
+			normal.Normalize();
+			point = 0.5f * (cA + cB);
+			separation = b2Dot(cB - cA, normal) - pc->radiusA - pc->radiusB;
+			return;
+		}
+
+		b2Transform xfA, xfB;
+		xfA.q.Set(aA);
+		xfB.q.Set(aB);
+		xfA.p = cA - b2Mul(xfA.q, pc->localCenterA);
+		xfB.p = cB - b2Mul(xfB.q, pc->localCenterB);
+		Initialize(pc, xfA, xfB, index);
+	}
+
 	b2Vec2 normal;
 	b2Vec2 point;
 	float32 separation;
@@ -672,16 +861,20 @@ bool b2ContactSolver::SolvePositionConstraints()
 {
 	float32 minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_count; ++i)
+	if (m_wideCount > 0)
+	{
+		minSeparation = SolveWidePositionConstraints();
+	}
+
+	for (int32 k = 0; k < m_scalarCount; ++k)
 	{
+		int32 i = m_scalarIndices ? m_scalarIndices[k] : k;
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
 		int32 indexA = pc->indexA;
 		int32 indexB = pc->indexB;
-		b2Vec2 localCenterA = pc->localCenterA;
 		float32 mA = pc->invMassA;
 		float32 iA = pc->invIA;
-		b2Vec2 localCenterB = pc->localCenterB;
 		float32 mB = pc->invMassB;
 		float32 iB = pc->invIB;
 		int32 pointCount = pc->pointCount;
@@ -695,14 +888,8 @@ bool b2ContactSolver::SolvePositionConstraints()
 		// Solve normal constraints
 		for (int32 j = 0; j < pointCount; ++j)
 		{
-			b2Transform xfA, xfB;
-			xfA.q.Set(aA);
-			xfB.q.Set(aB);
-			xfA.p = cA - b2Mul(xfA.q, localCenterA);
-			xfB.p = cB - b2Mul(xfB.q, localCenterB);
-
 			b2PositionSolverManifold psm;
-			psm.Initialize(pc, xfA, xfB, j);
+			psm.Initialize(pc, cA, aA, cB, aB, j);
 			b2Vec2 normal = psm.normal;
 
 			b2Vec2 point = psm.point;
@@ -757,8 +944,6 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 
 		int32 indexA = pc->indexA;
 		int32 indexB = pc->indexB;
-		b2Vec2 localCenterA = pc->localCenterA;
-		b2Vec2 localCenterB = pc->localCenterB;
 		int32 pointCount = pc->pointCount;
 
 		float32 mA = 0.0f;
@@ -786,14 +971,8 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 		// Solve normal constraints
 		for (int32 j = 0; j < pointCount; ++j)
 		{
-			b2Transform xfA, xfB;
-			xfA.q.Set(aA);
-			xfB.q.Set(aB);
-			xfA.p = cA - b2Mul(xfA.q, localCenterA);
-			xfB.p = cB - b2Mul(xfB.q, localCenterB);
-
 			b2PositionSolverManifold psm;
-			psm.Initialize(pc, xfA, xfB, j);
+			psm.Initialize(pc, cA, aA, cB, aB, j);
 			b2Vec2 normal = psm.normal;
 
 			b2Vec2 point = psm.point;
@@ -836,3 +1015,417 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 	// push the separation above -b2_linearSlop.
 	return minSeparation >= -1.5f * b2_linearSlop;
 }
+
+void b2ContactSolver::BuildWideConstraints()
+{
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(pc->indexA, pc->indexB) + 1);
+	}
+
+	// Each color has at most one partially filled group.
+	int32 maxWideCount = m_count / b2_solverLanes + b2_graphColorCount;
+	m_wideConstraints = (b2ContactConstraintWide*)m_allocator->Allocate(maxWideCount * sizeof(b2ContactConstraintWide));
+	m_scalarIndices = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	int32* colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+
+	// Greedy coloring. Static and kinematic bodies are not changed by the solver,
+	// so they may be shared by constraints of the same color.
+	m_scalarCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		bool solidA = pc->invMassA == 0.0f && pc->invIA == 0.0f;
+		bool solidB = pc->invMassB == 0.0f && pc->invIB == 0.0f;
+
+		colors[i] = -1;
+		if (pc->pointCount == 1)
+		{
+			uint32 used = (solidA ? 0 : bodyColors[pc->indexA]) | (solidB ? 0 : bodyColors[pc->indexB]);
+			for (int32 c = 0; c < b2_graphColorCount; ++c)
+			{
+				uint32 bit = 1u << c;
+				if ((used & bit) == 0)
+				{
+					colors[i] = c;
+					if (solidA == false)
+					{
+						bodyColors[pc->indexA] |= bit;
+					}
+					if (solidB == false)
+					{
+						bodyColors[pc->indexB] |= bit;
+					}
+					break;
+				}
+			}
+		}
+
+		if (colors[i] == -1)
+		{
+			m_scalarIndices[m_scalarCount++] = i;
+		}
+	}
+
+	// Pack the constraints of each color into groups of lanes.
+	m_wideCount = 0;
+	for (int32 c = 0; c < b2_graphColorCount; ++c)
+	{
+		b2ContactConstraintWide* wc = nullptr;
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			if (colors[i] != c)
+			{
+				continue;
+			}
+
+			if (wc == nullptr || wc->count == b2_solverLanes)
+			{
+				b2Assert(m_wideCount < maxWideCount);
+				wc = m_wideConstraints + m_wideCount++;
+				wc->count = 0;
+			}
+
+			wc->constraintIndex[wc->count++] = i;
+		}
+	}
+
+	m_allocator->Free(bodyColors);
+	m_allocator->Free(colors);
+}
+
+// Copy the velocity constraints to the wide constraints. Unused lanes have zero
+// mass, so they don't change the velocities.
+void b2ContactSolver::PrepareWideConstraints()
+{
+	for (int32 k = 0; k < m_wideCount; ++k)
+	{
+		b2ContactConstraintWide* wc = m_wideConstraints + k;
+
+		for (int32 lane = 0; lane < b2_solverLanes; ++lane)
+		{
+			if (lane >= wc->count)
+			{
+				wc->constraintIndex[lane] = wc->constraintIndex[0];
+				wc->indexA[lane] = wc->indexA[0];
+				wc->indexB[lane] = wc->indexB[0];
+				wc->invMassA[lane] = 0.0f;
+				wc->invMassB[lane] = 0.0f;
+				wc->invIA[lane] = 0.0f;
+				wc->invIB[lane] = 0.0f;
+				wc->normalX[lane] = 0.0f;
+				wc->normalY[lane] = 0.0f;
+				wc->rAX[lane] = 0.0f;
+				wc->rAY[lane] = 0.0f;
+				wc->rBX[lane] = 0.0f;
+				wc->rBY[lane] = 0.0f;
+				wc->normalMass[lane] = 0.0f;
+				wc->tangentMass[lane] = 0.0f;
+				wc->velocityBias[lane] = 0.0f;
+				wc->normalImpulse[lane] = 0.0f;
+				wc->tangentImpulse[lane] = 0.0f;
+				wc->friction[lane] = 0.0f;
+				wc->tangentSpeed[lane] = 0.0f;
+				continue;
+			}
+
+			const b2ContactVelocityConstraint* vc = m_velocityConstraints + wc->constraintIndex[lane];
+			const b2VelocityConstraintPoint* vcp = vc->points + 0;
+			wc->indexA[lane] = vc->indexA;
+			wc->indexB[lane] = vc->indexB;
+			wc->invMassA[lane] = vc->invMassA;
+			wc->invMassB[lane] = vc->invMassB;
+			wc->invIA[lane] = vc->invIA;
+			wc->invIB[lane] = vc->invIB;
+			wc->normalX[lane] = vc->normal.x;
+			wc->normalY[lane] = vc->normal.y;
+			wc->rAX[lane] = vcp->rA.x;
+			wc->rAY[lane] = vcp->rA.y;
+			wc->rBX[lane] = vcp->rB.x;
+			wc->rBY[lane] = vcp->rB.y;
+			wc->normalMass[lane] = vcp->normalMass;
+			wc->tangentMass[lane] = vcp->tangentMass;
+			wc->velocityBias[lane] = vcp->velocityBias;
+			wc->normalImpulse[lane] = vcp->normalImpulse;
+			wc->tangentImpulse[lane] = vcp->tangentImpulse;
+			wc->friction[lane] = vc->friction;
+			wc->tangentSpeed[lane] = vc->tangentSpeed;
+		}
+	}
+}
+
+#ifdef b2_useSSE2
+
+// Same as SolveVelocityConstraints for single point constraints.
+float32 b2ContactSolver::SolveWideVelocityConstraints()
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 maxImpulse = zero;
+
+	for (int32 k = 0; k < m_wideCount; ++k)
+	{
+		b2ContactConstraintWide* wc = m_wideConstraints + k;
+
+		const b2Velocity* vA0 = m_velocities + wc->indexA[0];
+		const b2Velocity* vA1 = m_velocities + wc->indexA[1];
+		const b2Velocity* vA2 = m_velocities + wc->indexA[2];
+		const b2Velocity* vA3 = m_velocities + wc->indexA[3];
+		const b2Velocity* vB0 = m_velocities + wc->indexB[0];
+		const b2Velocity* vB1 = m_velocities + wc->indexB[1];
+		const b2Velocity* vB2 = m_velocities + wc->indexB[2];
+		const b2Velocity* vB3 = m_velocities + wc->indexB[3];
+
+		__m128 vAX = _mm_setr_ps(vA0->v.x, vA1->v.x, vA2->v.x, vA3->v.x);
+		__m128 vAY = _mm_setr_ps(vA0->v.y, vA1->v.y, vA2->v.y, vA3->v.y);
+		__m128 wA = _mm_setr_ps(vA0->w, vA1->w, vA2->w, vA3->w);
+		__m128 vBX = _mm_setr_ps(vB0->v.x, vB1->v.x, vB2->v.x, vB3->v.x);
+		__m128 vBY = _mm_setr_ps(vB0->v.y, vB1->v.y, vB2->v.y, vB3->v.y);
+		__m128 wB = _mm_setr_ps(vB0->w, vB1->w, vB2->w, vB3->w);
+
+		const __m128 mA = _mm_loadu_ps(wc->invMassA);
+		const __m128 mB = _mm_loadu_ps(wc->invMassB);
+		const __m128 iA = _mm_loadu_ps(wc->invIA);
+		const __m128 iB = _mm_loadu_ps(wc->invIB);
+		const __m128 normalX = _mm_loadu_ps(wc->normalX);
+		const __m128 normalY = _mm_loadu_ps(wc->normalY);
+		const __m128 rAX = _mm_loadu_ps(wc->rAX);
+		const __m128 rAY = _mm_loadu_ps(wc->rAY);
+		const __m128 rBX = _mm_loadu_ps(wc->rBX);
+		const __m128 rBY = _mm_loadu_ps(wc->rBY);
+
+		// tangent = b2Cross(normal, 1.0f)
+		const __m128 tangentX = normalY;
+		const __m128 tangentY = _mm_sub_ps(zero, normalX);
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		{
+			// Relative velocity at contact
+			__m128 dvX = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(vBX, _mm_mul_ps(wB, rBY)), vAX), _mm_mul_ps(wA, rAY));
+			__m128 dvY = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(vBY, _mm_mul_ps(wB, rBX)), vAY), _mm_mul_ps(wA, rAX));
+
+			// Compute tangent force
+			__m128 vt = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(dvX, tangentX), _mm_mul_ps(dvY, tangentY)), _mm_loadu_ps(wc->tangentSpeed));
+			__m128 lambda = _mm_mul_ps(_mm_loadu_ps(wc->tangentMass), _mm_sub_ps(zero, vt));
+
+			// b2Clamp the accumulated force
+			__m128 oldImpulse = _mm_loadu_ps(wc->tangentImpulse);
+			__m128 maxFriction = _mm_mul_ps(_mm_loadu_ps(wc->friction), _mm_loadu_ps(wc->normalImpulse));
+			__m128 newImpulse = _mm_max_ps(_mm_sub_ps(zero, maxFriction), _mm_min_ps(_mm_add_ps(oldImpulse, lambda), maxFriction));
+			lambda = _mm_sub_ps(newImpulse, oldImpulse);
+			_mm_storeu_ps(wc->tangentImpulse, newImpulse);
+			maxImpulse = _mm_max_ps(maxImpulse, _mm_andnot_ps(signMask, lambda));
+
+			// Apply contact impulse
+			__m128 PX = _mm_mul_ps(lambda, tangentX);
+			__m128 PY = _mm_mul_ps(lambda, tangentY);
+
+			vAX = _mm_sub_ps(vAX, _mm_mul_ps(mA, PX));
+			vAY = _mm_sub_ps(vAY, _mm_mul_ps(mA, PY));
+			wA = _mm_sub_ps(wA, _mm_mul_ps(iA, _mm_sub_ps(_mm_mul_ps(rAX, PY), _mm_mul_ps(rAY, PX))));
+
+			vBX = _mm_add_ps(vBX, _mm_mul_ps(mB, PX));
+			vBY = _mm_add_ps(vBY, _mm_mul_ps(mB, PY));
+			wB = _mm_add_ps(wB, _mm_mul_ps(iB, _mm_sub_ps(_mm_mul_ps(rBX, PY), _mm_mul_ps(rBY, PX))));
+		}
+
+		// Solve normal constraints
+		{
+			// Relative velocity at contact
+			__m128 dvX = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(vBX, _mm_mul_ps(wB, rBY)), vAX), _mm_mul_ps(wA, rAY));
+			__m128 dvY = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(vBY, _mm_mul_ps(wB, rBX)), vAY), _mm_mul_ps(wA, rAX));
+
+			// Compute normal impulse
+			__m128 vn = _mm_add_ps(_mm_mul_ps(dvX, normalX), _mm_mul_ps(dvY, normalY));
+			__m128 lambda = _mm_mul_ps(_mm_sub_ps(zero, _mm_loadu_ps(wc->normalMass)), _mm_sub_ps(vn, _mm_loadu_ps(wc->velocityBias)));
+
+			// b2Clamp the accumulated impulse
+			__m128 oldImpulse = _mm_loadu_ps(wc->normalImpulse);
+			__m128 newImpulse = _mm_max_ps(_mm_add_ps(oldImpulse, lambda), zero);
+			lambda = _mm_sub_ps(newImpulse, oldImpulse);
+			_mm_storeu_ps(wc->normalImpulse, newImpulse);
+			maxImpulse = _mm_max_ps(maxImpulse, _mm_andnot_ps(signMask, lambda));
+
+			// Apply contact impulse
+			__m128 PX = _mm_mul_ps(lambda, normalX);
+			__m128 PY = _mm_mul_ps(lambda, normalY);
+
+			vAX = _mm_sub_ps(vAX, _mm_mul_ps(mA, PX));
+			vAY = _mm_sub_ps(vAY, _mm_mul_ps(mA, PY));
+			wA = _mm_sub_ps(wA, _mm_mul_ps(iA, _mm_sub_ps(_mm_mul_ps(rAX, PY), _mm_mul_ps(rAY, PX))));
+
+			vBX = _mm_add_ps(vBX, _mm_mul_ps(mB, PX));
+			vBY = _mm_add_ps(vBY, _mm_mul_ps(mB, PY));
+			wB = _mm_add_ps(wB, _mm_mul_ps(iB, _mm_sub_ps(_mm_mul_ps(rBX, PY), _mm_mul_ps(rBY, PX))));
+		}
+
+		float32 outAX[b2_solverLanes], outAY[b2_solverLanes], outWA[b2_solverLanes];
+		float32 outBX[b2_solverLanes], outBY[b2_solverLanes], outWB[b2_solverLanes];
+		_mm_storeu_ps(outAX, vAX);
+		_mm_storeu_ps(outAY, vAY);
+		_mm_storeu_ps(outWA, wA);
+		_mm_storeu_ps(outBX, vBX);
+		_mm_storeu_ps(outBY, vBY);
+		_mm_storeu_ps(outWB, wB);
+
+		// Scatter the velocities and keep the impulses of the velocity constraints
+		// up to date for StoreImpulses and b2Island::Report.
+		for (int32 lane = 0; lane < wc->count; ++lane)
+		{
+			b2Velocity* vA = m_velocities + wc->indexA[lane];
+			b2Velocity* vB = m_velocities + wc->indexB[lane];
+			vA->v.Set(outAX[lane], outAY[lane]);
+			vA->w = outWA[lane];
+			vB->v.Set(outBX[lane], outBY[lane]);
+			vB->w = outWB[lane];
+
+			b2VelocityConstraintPoint* vcp = m_velocityConstraints[wc->constraintIndex[lane]].points + 0;
+			vcp->normalImpulse = wc->normalImpulse[lane];
+			vcp->tangentImpulse = wc->tangentImpulse[lane];
+		}
+	}
+
+	float32 lanes[b2_solverLanes];
+	_mm_storeu_ps(lanes, maxImpulse);
+	return b2Max(b2Max(lanes[0], lanes[1]), b2Max(lanes[2], lanes[3]));
+}
+
+// Same as SolvePositionConstraints for single point constraints. The manifold is
+// evaluated per lane, the rest of the solve is done in lanes.
+float32 b2ContactSolver::SolveWidePositionConstraints()
+{
+	const __m128 zero = _mm_setzero_ps();
+	__m128 minSeparation = zero;
+
+	for (int32 k = 0; k < m_wideCount; ++k)
+	{
+		b2ContactConstraintWide* wc = m_wideConstraints + k;
+
+		float32 cAX[b2_solverLanes], cAY[b2_solverLanes], aA[b2_solverLanes];
+		float32 cBX[b2_solverLanes], cBY[b2_solverLanes], aB[b2_solverLanes];
+		float32 normalX[b2_solverLanes], normalY[b2_solverLanes];
+		float32 pointX[b2_solverLanes], pointY[b2_solverLanes];
+		float32 separation[b2_solverLanes];
+
+		for (int32 lane = 0; lane < b2_solverLanes; ++lane)
+		{
+			b2ContactPositionConstraint* pc = m_positionConstraints + wc->constraintIndex[lane];
+			const b2Position& positionA = m_positions[pc->indexA];
+			const b2Position& positionB = m_positions[pc->indexB];
+
+			cAX[lane] = positionA.c.x;
+			cAY[lane] = positionA.c.y;
+			aA[lane] = positionA.a;
+			cBX[lane] = positionB.c.x;
+			cBY[lane] = positionB.c.y;
+			aB[lane] = positionB.a;
+
+			if (lane >= wc->count)
+			{
+				// Unused lane has no error and zero mass.
+				normalX[lane] = 0.0f;
+				normalY[lane] = 0.0f;
+				pointX[lane] = positionA.c.x;
+				pointY[lane] = positionA.c.y;
+				separation[lane] = 0.0f;
+				continue;
+			}
+
+			b2PositionSolverManifold psm;
+			psm.Initialize(pc, positionA.c, positionA.a, positionB.c, positionB.a, 0);
+			normalX[lane] = psm.normal.x;
+			normalY[lane] = psm.normal.y;
+			pointX[lane] = psm.point.x;
+			pointY[lane] = psm.point.y;
+			separation[lane] = psm.separation;
+		}
+
+		const __m128 mA = _mm_loadu_ps(wc->invMassA);
+		const __m128 mB = _mm_loadu_ps(wc->invMassB);
+		const __m128 iA = _mm_loadu_ps(wc->invIA);
+		const __m128 iB = _mm_loadu_ps(wc->invIB);
+		const __m128 nX = _mm_loadu_ps(normalX);
+		const __m128 nY = _mm_loadu_ps(normalY);
+		const __m128 sep = _mm_loadu_ps(separation);
+		__m128 cAXv = _mm_loadu_ps(cAX);
+		__m128 cAYv = _mm_loadu_ps(cAY);
+		__m128 aAv = _mm_loadu_ps(aA);
+		__m128 cBXv = _mm_loadu_ps(cBX);
+		__m128 cBYv = _mm_loadu_ps(cBY);
+		__m128 aBv = _mm_loadu_ps(aB);
+
+		__m128 rAX = _mm_sub_ps(_mm_loadu_ps(pointX), cAXv);
+		__m128 rAY = _mm_sub_ps(_mm_loadu_ps(pointY), cAYv);
+		__m128 rBX = _mm_sub_ps(_mm_loadu_ps(pointX), cBXv);
+		__m128 rBY = _mm_sub_ps(_mm_loadu_ps(pointY), cBYv);
+
+		// Track max constraint error.
+		minSeparation = _mm_min_ps(minSeparation, sep);
+
+		// Prevent large corrections and allow slop.
+		__m128 C = _mm_max_ps(_mm_set1_ps(-b2_maxLinearCorrection),
+			_mm_min_ps(_mm_mul_ps(_mm_set1_ps(b2_baumgarte), _mm_add_ps(sep, _mm_set1_ps(b2_linearSlop))), zero));
+
+		// Compute the effective mass.
+		__m128 rnA = _mm_sub_ps(_mm_mul_ps(rAX, nY), _mm_mul_ps(rAY, nX));
+		__m128 rnB = _mm_sub_ps(_mm_mul_ps(rBX, nY), _mm_mul_ps(rBY, nX));
+		__m128 K = _mm_add_ps(_mm_add_ps(_mm_add_ps(mA, mB), _mm_mul_ps(_mm_mul_ps(iA, rnA), rnA)), _mm_mul_ps(_mm_mul_ps(iB, rnB), rnB));
+
+		// Compute normal impulse
+		__m128 positive = _mm_cmpgt_ps(K, zero);
+		__m128 impulse = _mm_and_ps(positive, _mm_div_ps(_mm_sub_ps(zero, C), _mm_or_ps(K, _mm_andnot_ps(positive, _mm_set1_ps(1.0f)))));
+
+		__m128 PX = _mm_mul_ps(impulse, nX);
+		__m128 PY = _mm_mul_ps(impulse, nY);
+
+		cAXv = _mm_sub_ps(cAXv, _mm_mul_ps(mA, PX));
+		cAYv = _mm_sub_ps(cAYv, _mm_mul_ps(mA, PY));
+		aAv = _mm_sub_ps(aAv, _mm_mul_ps(iA, _mm_sub_ps(_mm_mul_ps(rAX, PY), _mm_mul_ps(rAY, PX))));
+
+		cBXv = _mm_add_ps(cBXv, _mm_mul_ps(mB, PX));
+		cBYv = _mm_add_ps(cBYv, _mm_mul_ps(mB, PY));
+		aBv = _mm_add_ps(aBv, _mm_mul_ps(iB, _mm_sub_ps(_mm_mul_ps(rBX, PY), _mm_mul_ps(rBY, PX))));
+
+		_mm_storeu_ps(cAX, cAXv);
+		_mm_storeu_ps(cAY, cAYv);
+		_mm_storeu_ps(aA, aAv);
+		_mm_storeu_ps(cBX, cBXv);
+		_mm_storeu_ps(cBY, cBYv);
+		_mm_storeu_ps(aB, aBv);
+
+		for (int32 lane = 0; lane < wc->count; ++lane)
+		{
+			b2Position* positionA = m_positions + wc->indexA[lane];
+			b2Position* positionB = m_positions + wc->indexB[lane];
+			positionA->c.Set(cAX[lane], cAY[lane]);
+			positionA->a = aA[lane];
+			positionB->c.Set(cBX[lane], cBY[lane]);
+			positionB->a = aB[lane];
+		}
+	}
+
+	float32 lanes[b2_solverLanes];
+	_mm_storeu_ps(lanes, minSeparation);
+	return b2Min(b2Min(lanes[0], lanes[1]), b2Min(lanes[2], lanes[3]));
+}
+
+#else
+
+float32 b2ContactSolver::SolveWideVelocityConstraints()
+{
+	b2Assert(false);
+	return 0.0f;
+}
+
+float32 b2ContactSolver::SolveWidePositionConstraints()
+{
+	b2Assert(false);
+	return 0.0f;
+}
+
+#endif
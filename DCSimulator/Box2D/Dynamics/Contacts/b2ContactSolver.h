@@ -27,6 +27,10 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2ContactConstraintWide;
+
+/// Number of SIMD lanes of the wide contact solver.
+#define b2_solverLanes 4
 
 struct b2VelocityConstraintPoint
 {
@@ -75,12 +79,20 @@ public:
 	void InitializeVelocityConstraints();
 
 	void WarmStart();
-	void SolveVelocityConstraints();
+	/// Returns the largest impulse change of the iteration.
+	float32 SolveVelocityConstraints();
 	void StoreImpulses();
 
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	// Wide solver: single point constraints are colored so that constraints of the
+	// same color share no dynamic body, and solved b2_solverLanes at a time.
+	void BuildWideConstraints();
+	void PrepareWideConstraints();
+	float32 SolveWideVelocityConstraints();
+	float32 SolveWidePositionConstraints();
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -89,6 +101,12 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	// Constraints solved by the wide solver, and the rest solved sequentially.
+	b2ContactConstraintWide* m_wideConstraints;
+	int32 m_wideCount;
+	int32* m_scalarIndices;
+	int32 m_scalarCount;
 };
 
 #endif
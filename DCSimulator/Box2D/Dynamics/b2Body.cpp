@@ -22,7 +22,7 @@
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
 #include "Box2D/Dynamics/Joints/b2Joint.h"
 
-b2Body::b2Body(const b2BodyDef* bd, b2World* world)
+b2Body::b2Body(const b2BodyDef* bd, b2World* world, int32 slot)
 {
 	b2Assert(bd->position.IsValid());
 	b2Assert(bd->linearVelocity.IsValid());
@@ -31,6 +31,8 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	b2Assert(b2IsValid(bd->angularDamping) && bd->angularDamping >= 0.0f);
 	b2Assert(b2IsValid(bd->linearDamping) && bd->linearDamping >= 0.0f);
 
+	m_slot = slot;
+
 	m_flags = 0;
 
 	if (bd->bullet)
@@ -41,6 +43,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	{
 		m_flags |= e_fixedRotationFlag;
 	}
+	if (bd->orientationFree)
+	{
+		m_flags |= e_orientationFreeFlag;
+	}
 	if (bd->allowSleep)
 	{
 		m_flags |= e_autoSleepFlag;
@@ -171,6 +177,9 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return nullptr;
 	}
 
+	// Chain vertices use b2Alloc, which an arena world would not free.
+	b2Assert(m_world->m_allocator->IsArena() == false || def->shape->GetType() != b2Shape::e_chain);
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
@@ -269,6 +278,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		fixture->DestroyProxies(broadPhase);
+		m_world->m_contactManager.ReleasePairSlot(fixture);
 	}
 
 	fixture->m_body = nullptr;
@@ -446,7 +456,14 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
+	if (m_flags & e_orientationFreeFlag)
+	{
+		xf1.q = m_xf.q;
+	}
+	else
+	{
+		xf1.q.Set(m_sweep.a0);
+	}
 	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
@@ -539,6 +556,7 @@ void b2Body::Dump()
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
 	b2Log("  bd.awake = bool(%d);\n", m_flags & e_awakeFlag);
 	b2Log("  bd.fixedRotation = bool(%d);\n", m_flags & e_fixedRotationFlag);
+	b2Log("  bd.orientationFree = bool(%d);\n", m_flags & e_orientationFreeFlag);
 	b2Log("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
 	b2Log("  bd.active = bool(%d);\n", m_flags & e_activeFlag);
 	b2Log("  bd.gravityScale = %.15lef;\n", m_gravityScale);
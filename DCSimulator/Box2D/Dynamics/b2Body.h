@@ -63,6 +63,7 @@ struct b2BodyDef
 		allowSleep = true;
 		awake = true;
 		fixedRotation = false;
+		orientationFree = false;
 		bullet = false;
 		type = b2_staticBody;
 		active = true;
@@ -108,6 +109,12 @@ struct b2BodyDef
 	/// Should this body be prevented from rotating? Useful for characters.
 	bool fixedRotation;
 
+	/// Should the angle of this body be left out of the simulation? The angular
+	/// velocity is still solved, but the angle is not integrated and the transform
+	/// keeps its rotation, so no trigonometry is done per step. Useful for discs
+	/// centered on the body origin, whose shapes don't depend on the angle.
+	bool orientationFree;
+
 	/// Is this a fast moving body that should be prevented from tunneling through
 	/// other moving bodies? Note that all bodies are prevented from tunneling through
 	/// kinematic and static bodies. This setting is only considered on dynamic bodies.
@@ -358,6 +365,13 @@ public:
 	/// Does this body have fixed rotation?
 	bool IsFixedRotation() const;
 
+	/// Set this body to be orientation free (see b2BodyDef::orientationFree).
+	/// The angle is kept at its current value.
+	void SetOrientationFree(bool flag);
+
+	/// Is this body orientation free?
+	bool IsOrientationFree() const;
+
 	/// Get the list of all fixtures attached to this body.
 	b2Fixture* GetFixtureList();
 	const b2Fixture* GetFixtureList() const;
@@ -418,10 +432,11 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_orientationFreeFlag	= 0x0080
 	};
 
-	b2Body(const b2BodyDef* bd, b2World* world);
+	b2Body(const b2BodyDef* bd, b2World* world, int32 slot);
 	~b2Body();
 
 	void SynchronizeFixtures();
@@ -438,6 +453,7 @@ private:
 	uint16 m_flags;
 
 	int32 m_islandIndex;
+	int32 m_slot;			// index in b2BodySlots (-1: none)
 
 	b2Transform m_xf;		// the body origin transform
 	b2Sweep m_sweep;		// the swept motion for CCD
@@ -669,6 +685,23 @@ inline bool b2Body::IsFixedRotation() const
 	return (m_flags & e_fixedRotationFlag) == e_fixedRotationFlag;
 }
 
+inline void b2Body::SetOrientationFree(bool flag)
+{
+	if (flag)
+	{
+		m_flags |= e_orientationFreeFlag;
+	}
+	else
+	{
+		m_flags &= ~e_orientationFreeFlag;
+	}
+}
+
+inline bool b2Body::IsOrientationFree() const
+{
+	return (m_flags & e_orientationFreeFlag) == e_orientationFreeFlag;
+}
+
 inline void b2Body::SetSleepingAllowed(bool flag)
 {
 	if (flag)
@@ -855,7 +888,11 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse, bool wake)
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
+	// The rotation of an orientation free body doesn't change.
+	if ((m_flags & e_orientationFreeFlag) == 0)
+	{
+		m_xf.q.Set(m_sweep.a);
+	}
 	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
 }
 
@@ -865,8 +902,7 @@ inline void b2Body::Advance(float32 alpha)
 	m_sweep.Advance(alpha);
 	m_sweep.c = m_sweep.c0;
 	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	SynchronizeTransform();
 }
 
 inline b2World* b2Body::GetWorld()
@@ -25,13 +25,80 @@
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2Allocator* allocator)
+	: m_broadPhase(allocator)
 {
 	m_contactList = nullptr;
 	m_contactCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = nullptr;
+
+	m_pairTableEnabled = false;
+	m_freePairSlots = b2_pairTableSlots == 32 ? 0xFFFFFFFF : (1u << b2_pairTableSlots) - 1;
+	memset(m_pairTable, 0, sizeof(m_pairTable));
+	memset(m_pairActive, 0, sizeof(m_pairActive));
+}
+
+void b2ContactManager::SetPairTable(bool flag)
+{
+	// Fixtures registered to the table keep their contacts.
+	b2Assert(m_contactCount == 0);
+	m_pairTableEnabled = flag;
+}
+
+bool b2ContactManager::AcquirePairSlot(b2Fixture* fixture)
+{
+	if (fixture->m_pairSlot != -1)
+	{
+		return true;
+	}
+
+	// Only single child shapes (no chains) are registered.
+	if (m_pairTableEnabled == false || m_freePairSlots == 0 || fixture->m_proxyCount != 1)
+	{
+		return false;
+	}
+
+	int32 slot = 0;
+	while ((m_freePairSlots & (1u << slot)) == 0)
+	{
+		++slot;
+	}
+	m_freePairSlots &= ~(1u << slot);
+	fixture->m_pairSlot = slot;
+	return true;
+}
+
+void b2ContactManager::ReleasePairSlot(b2Fixture* fixture)
+{
+	int32 slot = fixture->m_pairSlot;
+	if (slot == -1)
+	{
+		return;
+	}
+
+	// Free the kept contacts of this fixture. They must be inactive because
+	// contacts of a fixture are destroyed before the fixture.
+	for (int32 other = 0; other < b2_pairTableSlots; ++other)
+	{
+		if (other == slot)
+		{
+			continue;
+		}
+
+		int32 index = GetPairIndex(slot, other);
+		b2Contact* c = m_pairTable[index];
+		if (c != nullptr)
+		{
+			b2Assert((m_pairActive[index >> 5] & (1u << (index & 31))) == 0);
+			b2Contact::Destroy(c, m_allocator);
+			m_pairTable[index] = nullptr;
+		}
+	}
+
+	m_freePairSlots |= 1u << slot;
+	fixture->m_pairSlot = -1;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -94,8 +161,26 @@ void b2ContactManager::Destroy(b2Contact* c)
 		bodyB->m_contactList = c->m_nodeB.next;
 	}
 
-	// Call the factory.
-	b2Contact::Destroy(c, m_allocator);
+	if (c->m_flags & b2Contact::e_pairTableFlag)
+	{
+		// Keep the contact in the pair table for reuse.
+		if (c->m_manifold.pointCount > 0 &&
+			fixtureA->IsSensor() == false &&
+			fixtureB->IsSensor() == false)
+		{
+			bodyA->SetAwake(true);
+			bodyB->SetAwake(true);
+		}
+
+		int32 index = GetPairIndex(fixtureA->m_pairSlot, fixtureB->m_pairSlot);
+		m_pairActive[index >> 5] &= ~(1u << (index & 31));
+		c->m_manifold.pointCount = 0;
+	}
+	else
+	{
+		// Call the factory.
+		b2Contact::Destroy(c, m_allocator);
+	}
 	--m_contactCount;
 }
 
@@ -194,10 +279,20 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// Does a contact already exist? With the pair table this is a bit test.
+	int32 pairIndex = -1;
+	if (m_pairTableEnabled && AcquirePairSlot(fixtureA) && AcquirePairSlot(fixtureB))
+	{
+		pairIndex = GetPairIndex(fixtureA->m_pairSlot, fixtureB->m_pairSlot);
+		if (m_pairActive[pairIndex >> 5] & (1u << (pairIndex & 31)))
+		{
+			return;
+		}
+	}
+
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
-	// Does a contact already exist?
-	b2ContactEdge* edge = bodyB->GetContactList();
+	b2ContactEdge* edge = (pairIndex == -1) ? bodyB->GetContactList() : nullptr;
 	while (edge)
 	{
 		if (edge->other == bodyA)
@@ -235,11 +330,33 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
-	// Call the factory.
-	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
-	if (c == nullptr)
+	b2Contact* c;
+	if (pairIndex != -1 && m_pairTable[pairIndex] != nullptr)
 	{
-		return;
+		// Reuse the kept contact.
+		c = m_pairTable[pairIndex];
+		c->Reset();
+		c->m_flags |= b2Contact::e_pairTableFlag;
+	}
+	else
+	{
+		// Call the factory.
+		c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
+		if (c == nullptr)
+		{
+			return;
+		}
+
+		if (pairIndex != -1)
+		{
+			m_pairTable[pairIndex] = c;
+			c->m_flags |= b2Contact::e_pairTableFlag;
+		}
+	}
+
+	if (pairIndex != -1)
+	{
+		m_pairActive[pairIndex >> 5] |= 1u << (pairIndex & 31);
 	}
 
 	// Contact creation may swap fixtures.
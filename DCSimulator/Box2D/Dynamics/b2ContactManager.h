@@ -24,13 +24,14 @@
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
+class b2Fixture;
 class b2BlockAllocator;
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2Allocator* allocator = nullptr);
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -40,6 +41,10 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// Contact pair table (see b2World::SetPairTable).
+	void SetPairTable(bool flag);
+	void ReleasePairSlot(b2Fixture* fixture);
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
@@ -47,6 +52,28 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+private:
+
+	// Index of the pair of slots in the triangular table.
+	static int32 GetPairIndex(int32 slotA, int32 slotB);
+
+	// Register a fixture to the table. Returns false if it can't be registered.
+	bool AcquirePairSlot(b2Fixture* fixture);
+
+	// Contacts between fixtures in the pair table are kept while they are
+	// inactive (not in the contact lists), so re-creating them needs no allocation.
+	bool m_pairTableEnabled;
+	uint32 m_freePairSlots;
+	b2Contact* m_pairTable[b2_pairTableSlots * (b2_pairTableSlots - 1) / 2];
+	uint32 m_pairActive[(b2_pairTableSlots * (b2_pairTableSlots - 1) / 2 + 31) / 32];
 };
 
+inline int32 b2ContactManager::GetPairIndex(int32 slotA, int32 slotB)
+{
+	int32 lo = b2Min(slotA, slotB);
+	int32 hi = b2Max(slotA, slotB);
+	return hi * (hi - 1) / 2 + lo;
+}
+
 #endif
@@ -233,6 +233,9 @@ protected:
 	bool m_isSensor;
 
 	void* m_userData;
+
+	// Slot in the contact pair table, -1 if not registered.
+	int32 m_pairSlot;
 };
 
 inline b2Shape::Type b2Fixture::GetType() const
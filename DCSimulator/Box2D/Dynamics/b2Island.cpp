@@ -168,10 +168,45 @@ b2Island::b2Island(
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+
+	m_cached = false;
+	m_storage = nullptr;
+}
+
+b2Island::b2Island(b2Allocator* storage)
+{
+	m_bodyCapacity = 0;
+	m_contactCapacity = 0;
+	m_jointCapacity = 0;
+	m_bodyCount = 0;
+	m_contactCount = 0;
+	m_jointCount = 0;
+
+	m_allocator = nullptr;
+	m_listener = nullptr;
+
+	m_bodies = nullptr;
+	m_contacts = nullptr;
+	m_joints = nullptr;
+	m_velocities = nullptr;
+	m_positions = nullptr;
+
+	m_cached = true;
+	m_storage = storage ? storage : b2GetHeapAllocator();
 }
 
 b2Island::~b2Island()
 {
+	if (m_cached)
+	{
+		m_storage->Free(m_positions);
+		m_storage->Free(m_velocities);
+		m_storage->Free(m_joints);
+		m_storage->Free(m_contacts);
+		m_storage->Free(m_bodies);
+		return;
+	}
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
@@ -180,6 +215,40 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
+void b2Island::Reserve(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
+	b2StackAllocator* allocator, b2ContactListener* listener)
+{
+	b2Assert(m_cached);
+
+	m_allocator = allocator;
+	m_listener = listener;
+
+	if (bodyCapacity > m_bodyCapacity)
+	{
+		m_storage->Free(m_bodies);
+		m_storage->Free(m_velocities);
+		m_storage->Free(m_positions);
+		m_bodyCapacity = bodyCapacity;
+		m_bodies = (b2Body**)m_storage->Allocate(m_bodyCapacity * sizeof(b2Body*));
+		m_velocities = (b2Velocity*)m_storage->Allocate(m_bodyCapacity * sizeof(b2Velocity));
+		m_positions = (b2Position*)m_storage->Allocate(m_bodyCapacity * sizeof(b2Position));
+	}
+
+	if (contactCapacity > m_contactCapacity)
+	{
+		m_storage->Free(m_contacts);
+		m_contactCapacity = contactCapacity;
+		m_contacts = (b2Contact**)m_storage->Allocate(m_contactCapacity * sizeof(b2Contact*));
+	}
+
+	if (jointCapacity > m_jointCapacity)
+	{
+		m_storage->Free(m_joints);
+		m_jointCapacity = jointCapacity;
+		m_joints = (b2Joint**)m_storage->Allocate(m_jointCapacity * sizeof(b2Joint*));
+	}
+}
+
 void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
 	b2Timer timer;
@@ -257,6 +326,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	// Solve velocity constraints
 	timer.Reset();
+	int32 velocityIterations = 0;
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
 		for (int32 j = 0; j < m_jointCount; ++j)
@@ -264,8 +334,19 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			m_joints[j]->SolveVelocityConstraints(solverData);
 		}
 
-		contactSolver.SolveVelocityConstraints();
+		float32 maxImpulse = contactSolver.SolveVelocityConstraints();
+		++velocityIterations;
+
+		// Stop when the contact impulses converged. Joints don't report
+		// their impulses, so they always use all iterations.
+		if (step.adaptiveVelocity && m_jointCount == 0 &&
+			velocityIterations >= b2_minVelocityIterations &&
+			maxImpulse < b2_velocityIterationTolerance)
+		{
+			break;
+		}
 	}
+	profile->velocityIterations = velocityIterations;
 
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
@@ -331,7 +412,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		b2Body* body = m_bodies[i];
 		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
+		if ((body->m_flags & b2Body::e_orientationFreeFlag) == 0)
+		{
+			body->m_sweep.a = m_positions[i].a;
+		}
 		body->m_linearVelocity = m_velocities[i].v;
 		body->m_angularVelocity = m_velocities[i].w;
 		body->SynchronizeTransform();
@@ -381,6 +465,83 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 }
 
+void b2Island::SolveSingle(b2Body* b, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+{
+	b2Assert(b->m_type != b2_staticBody);
+
+	float32 h = step.dt;
+
+	b2Vec2 c = b->m_sweep.c;
+	float32 a = b->m_sweep.a;
+	b2Vec2 v = b->m_linearVelocity;
+	float32 w = b->m_angularVelocity;
+
+	// Store positions for continuous collision.
+	b->m_sweep.c0 = b->m_sweep.c;
+	b->m_sweep.a0 = b->m_sweep.a;
+
+	if (b->m_type == b2_dynamicBody)
+	{
+		// Integrate velocities.
+		v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
+		w += h * b->m_invI * b->m_torque;
+
+		// Apply damping.
+		v *= 1.0f / (1.0f + h * b->m_linearDamping);
+		w *= 1.0f / (1.0f + h * b->m_angularDamping);
+	}
+
+	// Check for large velocities
+	b2Vec2 translation = h * v;
+	if (b2Dot(translation, translation) > b2_maxTranslationSquared)
+	{
+		float32 ratio = b2_maxTranslation / translation.Length();
+		v *= ratio;
+	}
+
+	float32 rotation = h * w;
+	if (rotation * rotation > b2_maxRotationSquared)
+	{
+		float32 ratio = b2_maxRotation / b2Abs(rotation);
+		w *= ratio;
+	}
+
+	// Integrate
+	c += h * v;
+	b->m_sweep.c = c;
+	if ((b->m_flags & b2Body::e_orientationFreeFlag) == 0)
+	{
+		a += h * w;
+		b->m_sweep.a = a;
+	}
+	b->m_linearVelocity = v;
+	b->m_angularVelocity = w;
+	b->SynchronizeTransform();
+
+	if (allowSleep)
+	{
+		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
+		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+
+		if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
+			b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
+			b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+		{
+			b->m_sleepTime = 0.0f;
+		}
+		else
+		{
+			b->m_sleepTime += h;
+
+			// Without contacts the position solve succeeds on its first iteration.
+			if (b->m_sleepTime >= b2_timeToSleep && step.positionIterations > 0)
+			{
+				b->SetAwake(false);
+			}
+		}
+	}
+}
+
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
 {
 	b2Assert(toiIndexA < m_bodyCount);
@@ -450,9 +611,15 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 	// Leap of faith to new safe state.
 	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
 	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	if (m_bodies[toiIndexA]->IsOrientationFree() == false)
+	{
+		m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
+	}
+	if (m_bodies[toiIndexB]->IsOrientationFree() == false)
+	{
+		m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	}
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -504,7 +671,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 		// Sync bodies
 		b2Body* body = m_bodies[i];
 		body->m_sweep.c = c;
-		body->m_sweep.a = a;
+		if ((body->m_flags & b2Body::e_orientationFreeFlag) == 0)
+		{
+			body->m_sweep.a = a;
+		}
 		body->m_linearVelocity = v;
 		body->m_angularVelocity = w;
 		body->SynchronizeTransform();
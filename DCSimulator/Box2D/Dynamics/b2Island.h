@@ -36,8 +36,17 @@ class b2Island
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
 			b2StackAllocator* allocator, b2ContactListener* listener);
+
+	/// Island which keeps its storage across steps. Call Reserve before use.
+	/// The storage is taken from storage (nullptr: b2Alloc/b2Free).
+	b2Island(b2Allocator* storage = nullptr);
+
 	~b2Island();
 
+	/// Grow the storage of an island made with the default constructor.
+	void Reserve(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
+			b2StackAllocator* allocator, b2ContactListener* listener);
+
 	void Clear()
 	{
 		m_bodyCount = 0;
@@ -49,6 +58,10 @@ public:
 
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
+	/// Same as Solve for an island of a single body without contacts and joints,
+	/// without building the island.
+	static void SolveSingle(b2Body* body, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+
 	void Add(b2Body* body)
 	{
 		b2Assert(m_bodyCount < m_bodyCapacity);
@@ -88,6 +101,10 @@ public:
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	// Storage is allocated by m_storage and kept across steps.
+	bool m_cached;
+	b2Allocator* m_storage;
 };
 
 #endif
@@ -32,6 +32,10 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+
+	// Counters of the solver (not times)
+	int32 islandCount;
+	int32 velocityIterations;	///< sum over islands
 };
 
 /// This is an internal structure.
@@ -43,6 +47,7 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool adaptiveVelocity;	// stop velocity iterations when the impulses converged
 };
 
 /// This is an internal structure.
@@ -34,7 +34,12 @@
 #include "Box2D/Common/b2Timer.h"
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2Allocator* allocator)
+	: m_allocator(allocator ? allocator : b2GetHeapAllocator()),
+	m_blockAllocator(m_allocator),
+	m_stackAllocator(m_allocator),
+	m_contactManager(m_allocator),
+	m_island(m_allocator)
 {
 	m_destructionListener = nullptr;
 	g_debugDraw = nullptr;
@@ -42,12 +47,16 @@ b2World::b2World(const b2Vec2& gravity)
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
 
+	memset(&m_bodySlots, 0, sizeof(b2BodySlots));
+	m_bodySlotCount = 0;
+
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_adaptiveVelocity = false;
 
 	m_stepComplete = true;
 
@@ -65,6 +74,12 @@ b2World::b2World(const b2Vec2& gravity)
 
 b2World::~b2World()
 {
+	// The whole world is released with the arena.
+	if (m_allocator->IsArena())
+	{
+		return;
+	}
+
 	// Some shapes allocate using b2Alloc.
 	b2Body* b = m_bodyList;
 	while (b)
@@ -82,6 +97,68 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	m_allocator->Free(m_bodySlots.bodies);
+}
+
+void b2World::SetBodySlots(int32 capacity)
+{
+	b2Assert(m_bodyCount == 0);
+	if (m_bodyCount > 0)
+	{
+		return;
+	}
+
+	m_allocator->Free(m_bodySlots.bodies);
+	memset(&m_bodySlots, 0, sizeof(b2BodySlots));
+	if (capacity <= 0)
+	{
+		return;
+	}
+
+	int32 size = capacity * sizeof(b2Body*);
+	m_bodySlots.capacity = capacity;
+	m_bodySlots.bodies = (b2Body**)m_allocator->Allocate(size);
+	memset(m_bodySlots.bodies, 0, size);
+}
+
+void b2World::GetMemoryStats(b2MemoryStats* stats) const
+{
+	stats->blockChunks = m_blockAllocator.GetChunkCount();
+	stats->stackSize = m_stackAllocator.GetSize();
+	stats->stackMaxAllocation = m_stackAllocator.GetMaxAllocation();
+	stats->stackFallbacks = m_stackAllocator.GetFallbackCount();
+}
+
+// Find a free slot in the body slot table (-1 if full).
+int32 b2World::AcquireBodySlot()
+{
+	b2BodySlots& slots = m_bodySlots;
+	for (int32 i = 0; i < slots.count; ++i)
+	{
+		if (slots.bodies[i] == nullptr)
+		{
+			return i;
+		}
+	}
+
+	if (slots.count < slots.capacity)
+	{
+		return slots.count++;
+	}
+
+	return -1;
+}
+
+void b2World::ReleaseBodySlot(int32 slot)
+{
+	b2BodySlots& slots = m_bodySlots;
+	slots.bodies[slot] = nullptr;
+	while (slots.count > 0 && slots.bodies[slots.count - 1] == nullptr)
+	{
+		--slots.count;
+	}
+	--m_bodySlotCount;
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -112,8 +189,14 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 		return nullptr;
 	}
 
+	int32 slot = AcquireBodySlot();
 	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
-	b2Body* b = new (mem) b2Body(def, this);
+	b2Body* b = new (mem) b2Body(def, this, slot);
+	if (slot >= 0)
+	{
+		m_bodySlots.bodies[slot] = b;
+		++m_bodySlotCount;
+	}
 
 	// Add to world doubly linked list.
 	b->m_prev = nullptr;
@@ -178,6 +261,7 @@ void b2World::DestroyBody(b2Body* b)
 		}
 
 		f0->DestroyProxies(&m_contactManager.m_broadPhase);
+		m_contactManager.ReleasePairSlot(f0);
 		f0->Destroy(&m_blockAllocator);
 		f0->~b2Fixture();
 		m_blockAllocator.Free(f0, sizeof(b2Fixture));
@@ -205,6 +289,10 @@ void b2World::DestroyBody(b2Body* b)
 	}
 
 	--m_bodyCount;
+	if (b->m_slot >= 0)
+	{
+		ReleaseBodySlot(b->m_slot);
+	}
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
@@ -388,13 +476,23 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.islandCount = 0;
+	m_profile.velocityIterations = 0;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
+	// Every body is an island of its own if nothing touches.
+	if (SolveSingles(step))
+	{
+		return;
+	}
+
+	// Size the island for the worst case. The storage is kept for the next steps.
+	b2Island& island = m_island;
+	island.Reserve(m_bodyCount,
 					m_contactManager.m_contactCount,
 					m_jointCount,
 					&m_stackAllocator,
 					m_contactManager.m_contactListener);
+	island.Clear();
 
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
@@ -532,6 +630,8 @@ void b2World::Solve(const b2TimeStep& step)
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
+		m_profile.islandCount++;
+		m_profile.velocityIterations += profile.velocityIterations;
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -573,6 +673,75 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 }
 
+// Fast path of Solve when there are no joints and no touching contacts, which is
+// the case while stones are sliding alone. Each awake body is integrated directly
+// without clearing the island flags, building islands and contact solvers.
+// Returns false if the general path must be used.
+bool b2World::SolveSingles(const b2TimeStep& step)
+{
+	if (m_jointCount > 0)
+	{
+		return false;
+	}
+
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		if (c->IsEnabled() && c->IsTouching() &&
+			c->m_fixtureA->m_isSensor == false && c->m_fixtureB->m_isSensor == false)
+		{
+			return false;
+		}
+	}
+
+	b2Timer timer;
+
+	// Bodies in the slot table (in the order of the body list)
+	const b2BodySlots& slots = m_bodySlots;
+	const uint16 awakeActive = b2Body::e_awakeFlag | b2Body::e_activeFlag;
+	for (int32 i = slots.count - 1; i >= 0; --i)
+	{
+		b2Body* b = slots.bodies[i];
+		if (b == nullptr || (b->m_flags & awakeActive) != awakeActive || b->m_type == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2Island::SolveSingle(b, step, m_gravity, m_allowSleep);
+		m_profile.islandCount++;
+
+		// Update fixtures (for broad-phase).
+		b->SynchronizeFixtures();
+	}
+
+	// Bodies without a slot
+	if (m_bodySlotCount < m_bodyCount)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			if (b->m_slot >= 0 || b->IsAwake() == false || b->IsActive() == false || b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			b2Island::SolveSingle(b, step, m_gravity, m_allowSleep);
+			m_profile.islandCount++;
+
+			// Update fixtures (for broad-phase).
+			b->SynchronizeFixtures();
+		}
+	}
+	m_profile.solvePosition = timer.GetMilliseconds();
+
+	{
+		b2Timer timer;
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+
+	return true;
+}
+
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
@@ -860,6 +1029,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.adaptiveVelocity = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -923,6 +1093,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.adaptiveVelocity = m_adaptiveVelocity;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
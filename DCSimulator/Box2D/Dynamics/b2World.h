@@ -23,6 +23,7 @@
 #include "Box2D/Common/b2BlockAllocator.h"
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Dynamics/b2ContactManager.h"
+#include "Box2D/Dynamics/b2Island.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/b2TimeStep.h"
 
@@ -35,6 +36,24 @@ class b2Draw;
 class b2Fixture;
 class b2Joint;
 
+/// Bodies in a contiguous table, indexed by b2Body::m_slot. Hot loops walk the
+/// table instead of the body list; the state itself stays in the bodies.
+struct b2BodySlots
+{
+	int32 capacity;
+	int32 count;			///< slots [0, count) may be in use
+	b2Body** bodies;		///< nullptr for a free slot
+};
+
+/// Memory statistics of a world
+struct b2MemoryStats
+{
+	int32 blockChunks;			///< chunks of the block allocator
+	int32 stackSize;			///< size of the stack memory for per step allocations
+	int32 stackMaxAllocation;	///< high-water mark of per step allocations
+	int32 stackFallbacks;		///< per step allocations which did not fit the stack memory
+};
+
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
 /// management facilities.
@@ -43,11 +62,17 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator the allocator of the world memory (nullptr: b2Alloc/b2Free).
+	/// It must outlive the world.
+	b2World(const b2Vec2& gravity, b2Allocator* allocator = nullptr);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
+	/// On an arena allocator nothing is destroyed; the owner releases the arena.
 	~b2World();
 
+	/// Get the allocator of the world memory.
+	b2Allocator* GetAllocator() const { return m_allocator; }
+
 	/// Register a destruction listener. The listener is owned by you and must
 	/// remain in scope.
 	void SetDestructionListener(b2DestructionListener* listener);
@@ -157,6 +182,39 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable adaptive velocity iterations. Velocity iterations of an island stop
+	/// when the contact impulses converged (see b2_velocityIterationTolerance), so the
+	/// velocity iteration count passed to Step is the maximum.
+	void SetAdaptiveVelocityIterations(bool flag) { m_adaptiveVelocity = flag; }
+	bool GetAdaptiveVelocityIterations() const { return m_adaptiveVelocity; }
+
+	/// Enable/disable the contact pair table. Contacts between up to b2_pairTableSlots
+	/// single child fixtures are kept in a table while they are inactive, so that
+	/// contacts coming and going need no allocation. Set this before creating fixtures.
+	void SetPairTable(bool flag) { m_contactManager.SetPairTable(flag); }
+
+	/// Keep up to capacity bodies in a slot table, which the single body solver walks
+	/// instead of the body list. Bodies created beyond the capacity have no slot.
+	/// Set this before creating bodies.
+	void SetBodySlots(int32 capacity);
+
+	/// Set the size of the stack memory for per step allocations (default b2_stackSize).
+	/// It is taken from the world allocator on the first step and grows to the high-water mark.
+	void SetStackSize(int32 size) { m_stackAllocator.SetSize(size); }
+
+	/// Use memory of the caller for per step allocations (not grown or freed). The memory
+	/// can be shared by the worlds of a thread, since the stack is empty between steps.
+	void SetStackBuffer(void* data, int32 size) { m_stackAllocator.SetBuffer(data, size); }
+
+	/// Get the high-water mark of per step allocations in bytes.
+	int32 GetStackMaxAllocation() const { return m_stackAllocator.GetMaxAllocation(); }
+
+	/// Get the memory statistics of the world.
+	void GetMemoryStats(b2MemoryStats* stats) const;
+
+	/// Get the body slot table.
+	const b2BodySlots& GetBodySlots() const { return m_bodySlots; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -224,12 +282,17 @@ private:
 	friend class b2ContactManager;
 	friend class b2Controller;
 
+	int32 AcquireBodySlot();
+	void ReleaseBodySlot(int32 slot);
+
 	void Solve(const b2TimeStep& step);
+	bool SolveSingles(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
+	b2Allocator* m_allocator;
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
@@ -240,6 +303,9 @@ private:
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
+	b2BodySlots m_bodySlots;
+	int32 m_bodySlotCount;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
@@ -257,10 +323,14 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_adaptiveVelocity;
 
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+
+	// Island storage kept across steps.
+	b2Island m_island;
 };
 
 inline b2Body* b2World::GetBodyList()
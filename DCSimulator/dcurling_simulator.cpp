@@ -1,5 +1,8 @@
 #include "dcurling_simulator.h"
+#include "dcurling_simulator_internal.h"
+#include "dcurling_simulator_simd.h"
 
+#include <atomic>
 #include <random>
 #include <cmath>
 
@@ -27,40 +30,25 @@ namespace digital_curling {
 
 	namespace b2simulator {
 
-		// Constant values for Stone
-		constexpr float kStoneDensity    = 10.0f;
-		constexpr float kStoneResitution = 1.0f;
-		constexpr float kStoneFriction   = 12.009216f;
-		constexpr float kStandardAngle   = 0.066696f;
-		//constexpr float kForceVerticalBase = kStandardAngle * kStoneFriction;
-
-		// Constant values for Rink
-		constexpr float kPlayAreaXLeft   = 0.000f + kStoneR;
-		constexpr float kPlayAreaXRight  = kSideX - kStoneR;
-		constexpr float kPlayAreaYTop    = 3.050f + kStoneR;
-		constexpr float kPlayAreaYBottom = kHogY - kStoneR;
-		constexpr float kRinkYTop        = 0.000f + kStoneR;
-		constexpr float kRinkYBottom     = 3.050f + kRinkHeight - kStoneR;
-		constexpr float kHackY           = 41.280f;     // Y coord of Hack?
-
-		// Constant values for simulation
-		constexpr int kVelocityIterations = 10;        // Iteration?
-		constexpr int kPositionIterations = 10;        // Iteration?
-		constexpr float kTimeStep = (1.0f / 1000.0f);  // Flame rate
-
 		// Options
 		const unsigned int kNumFreeguard = 4;     // Num of shot for freeguard rule
 		StoneArea kAreaFreeguard = IN_FREEGUARD;  // Area of unremoval stones
 		unsigned int num_freeguard = kNumFreeguard;
 		StoneArea area_freeguard = kAreaFreeguard;
+		std::atomic<bool> step_stats(false);      // Count statistics of each step
 
 		// Create body (= stone)
-		b2Body *CreateBody(float x, float y, b2World &world) {
+		//  index : index of stone in GameState (kept as user data of the body)
+		//  awake : false to create a parked (sleeping) stone
+		b2Body *CreateBody(float x, float y, unsigned int index, b2World &world, bool awake = true) {
 			b2BodyDef body_def;
 
 			body_def.type = b2_dynamicBody;  // set body type as dynamic
 			body_def.position.Set(x, y);     // set position (x, y)
 			body_def.angle = 0.0f;           // set angle  0 (not affected by angle?)
+			body_def.orientationFree = true; // angle is not used (only angular velocity is)
+			body_def.awake = awake;
+			body_def.userData = reinterpret_cast<void*>(static_cast<uintptr_t>(index));
 
 			// Create body
 			b2Body *body = world.CreateBody(&body_def);
@@ -84,32 +72,99 @@ namespace digital_curling {
 			return body;
 		}
 
+		// Index of stone in GameState
+		inline unsigned int StoneIndex(const b2Body *body) {
+			return static_cast<unsigned int>(reinterpret_cast<uintptr_t>(body->GetUserData()));
+		}
+
+		// Arena of worlds in this thread
+		thread_local b2ArenaAllocator world_arena;
+		thread_local bool world_arena_used = false;
+
+		// Park stones at rest (as sleeping bodies) until a moving stone touches them
+		//  Box2D wakes a sleeping body when a contact with it starts touching,
+		//  so parked stones are not solved or integrated while they are at rest.
+		constexpr bool kParkStones = true;
+
+		// Per step memory shared by worlds in this thread (16 stones need about 6 KB)
+		constexpr int kWorldStackSize = 16 * 1024;
+		alignas(16) thread_local char world_stack[kWorldStackSize];
+
+		// Arena for the world of a board
+		//  The world is released at once when the board is destroyed.
+		//  Nested boards in a thread use the heap (nullptr).
+		class WorldArena {
+		public:
+			WorldArena() : arena_(world_arena_used ? nullptr : &world_arena) {
+				world_arena_used = true;
+			}
+			~WorldArena() {
+				if (arena_ != nullptr) {
+					arena_->Reset();
+					world_arena_used = false;
+				}
+			}
+
+			b2ArenaAllocator *get() const { return arena_; }
+
+		private:
+			b2ArenaAllocator *arena_;
+		};
+
+		int GetStoneArea(const b2Vec2 &pos);
+
 		// State of Board for b2d simulator
 		class Board {
 		public:
 			// Set stones into board
-			Board(GameState const &gs, ShotVec const &vec) : world_(b2Vec2(0, 0)) {
+			Board(GameState const &gs, ShotVec const &vec)
+				: Board(gs, b2Vec2(kCenterX, kHackY), b2Vec2(vec.x, vec.y),
+					vec.angle ? -1 * kStandardAngle : kStandardAngle) {}
+
+			// Set stones into board with delivered stone in flight
+			Board(GameState const &gs, const b2Vec2 &position, const b2Vec2 &velocity, float angular_velocity)
+				: world_(b2Vec2(0, 0), arena_.get()), body_() {
+				// Keep contacts between stones (at most 16) without allocation
+				world_.SetPairTable(true);
+				// Stop velocity iterations when contacts are resolved
+				world_.SetAdaptiveVelocityIterations(true);
+				// Keep stones (at most 16) in slot table of the world
+				world_.SetBodySlots(16);
+				// Use scratch memory of this thread for per step allocations
+				world_.SetStackBuffer(world_stack, kWorldStackSize);
 				// Set shot_num_
 				shot_num_ = gs.ShotNum;
 				// Create bodies by positions of stone in GameState
+				//  Removed stones (recorded as (0, 0) by UpdateState) are out of rink,
+				//  so they are not put into the world.
+				//  Stones at rest are parked until a moving stone touches them.
+				in_play_ = 0;
+				moving_ = 0;
+				awake_ = 0;
 				for (unsigned int i = 0; i < gs.ShotNum; i++) {
-					body_[i] = CreateBody(gs.body[i][0], gs.body[i][1], world_);
+					if (GetStoneArea(b2Vec2(gs.body[i][0], gs.body[i][1])) != OUT_OF_RINK) {
+						body_[i] = CreateBody(gs.body[i][0], gs.body[i][1], i, world_, !kParkStones);
+						in_play_ |= 1u << i;
+					}
 				}
 
 				// Set ShotVec
 				assert(shot_num_ < 16);
 				// Create body
-				body_[shot_num_] = CreateBody(kCenterX, kHackY, world_);
+				body_[shot_num_] = CreateBody(position.x, position.y, shot_num_, world_);
+				in_play_ |= 1u << shot_num_;
+				moving_ |= 1u << shot_num_;
 				// Set verocity
-				body_[shot_num_]->SetLinearVelocity(b2Vec2(vec.x, vec.y));
-				if (vec.angle) {
-					body_[shot_num_]->SetAngularVelocity(-1 * kStandardAngle);
-				}
-				else {
-					body_[shot_num_]->SetAngularVelocity(kStandardAngle);
-				}
+				body_[shot_num_]->SetLinearVelocity(velocity);
+				body_[shot_num_]->SetAngularVelocity(angular_velocity);
 			}
 			~Board() {
+				RecordMemoryStats();
+
+				// Bodies on an arena are released with the world
+				if (arena_.get() != nullptr) {
+					return;
+				}
 				for (unsigned int i = 0; i < 16; i++) {
 					if (body_[i] != nullptr) {
 						world_.DestroyBody(body_[i]);
@@ -117,8 +172,37 @@ namespace digital_curling {
 				}
 			}
 
+			// Remove stone from the world
+			void RemoveStone(unsigned int i) {
+				world_.DestroyBody(body_[i]);
+				body_[i] = nullptr;
+				in_play_ &= ~(1u << i);
+				moving_ &= ~(1u << i);
+				awake_ &= ~(1u << i);
+			}
+
+			// Check stone i touches another stone (contacts of the last step)
+			bool IsTouching(unsigned int i) const {
+				if (body_[i] == nullptr) {
+					return false;
+				}
+				for (const b2ContactEdge *edge = body_[i]->GetContactList(); edge != nullptr; edge = edge->next) {
+					if (edge->contact->IsTouching()) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// Record memory statistics of the world to last_stats
+			void RecordMemoryStats() const;
+
+			WorldArena arena_;  // (must be declared before world_)
 			b2World world_;
 			b2Body *body_[16];
+			unsigned int in_play_;  // Bit i is set if stone i is in the world
+			unsigned int moving_;   // Bit i is set if stone i is moving (updated by FrictionAll)
+			unsigned int awake_;    // Bit i is set if stone i was awake in the last step (updated by FrictionAll)
 			unsigned int shot_num_;
 		};
 
@@ -191,143 +275,354 @@ namespace digital_curling {
 			}
 		}
 
+		// Statistics of the last simulation in this thread
+		thread_local SimStats last_stats;
+
+		// Add statistics of a step
+		inline void CountStep(const b2World &world) {
+			const b2Profile &profile = world.GetProfile();
+			last_stats.steps++;
+			last_stats.islands += profile.islandCount;
+			last_stats.velocity_iterations += profile.velocityIterations;
+			last_stats.gjk_calls = b2_gjkCalls;
+			last_stats.gjk_iterations = b2_gjkIters;
+			last_stats.toi_calls = b2_toiCalls;
+			last_stats.toi_iterations = b2_toiIters;
+		}
+
+		void Board::RecordMemoryStats() const {
+			b2MemoryStats stats;
+			world_.GetMemoryStats(&stats);
+			last_stats.stack_bytes = stats.stackMaxAllocation;
+			last_stats.stack_fallbacks = stats.stackFallbacks;
+			last_stats.block_chunks = stats.blockChunks;
+			last_stats.arena_bytes = (arena_.get() != nullptr) ? arena_.get()->GetAllocation() : 0;
+		}
+
+		// Count heap allocations of Box2D during lifetime (declare before Board)
+		class HeapCounter {
+		public:
+			HeapCounter() : base_(b2_allocStats) {
+				b2_allocStats.maxBytes = b2_allocStats.bytes;
+			}
+			~HeapCounter() {
+				last_stats.heap_allocations = b2_allocStats.allocCount - base_.allocCount;
+				last_stats.heap_bytes = static_cast<int>(b2_allocStats.allocBytes - base_.allocBytes);
+				last_stats.heap_peak_bytes = b2_allocStats.maxBytes - base_.bytes;
+			}
+
+		private:
+			b2AllocStats base_;
+		};
+
+		// Clear statistics (and counters of Box2D in this thread)
+		void ResetStats() {
+			last_stats = SimStats();
+#ifdef b2_useSSE2
+			last_stats.simd_path = SIMD_SSE2;
+#endif // b2_useSSE2
+			b2_gjkCalls = b2_gjkIters = 0;
+			b2_toiCalls = b2_toiIters = 0;
+		}
+
+		// Get statistics of the last simulation in this thread
+		void GetLastSimStats(SimStats* const stats) {
+			*stats = last_stats;
+		}
+
+		// Enable statistics of each step
+		void EnableStepStats(bool enable) {
+			step_stats = enable;
+		}
+
+#ifdef b2_useSSE2
+		// Add friction to 4 stones in SSE2 lanes
+		//  Same operations as FrictionStep (results are bit-identical).
+		//  v     : velocities of 4 stones (x0, y0, ..., x3, y3), updated
+		//  angle : angular velocities of 4 stones, set to 0 for stopped stones
+		//  lanes : mask of stones to be updated (other lanes are kept)
+		//  returns mask of lanes which are stopped
+		inline int FrictionStep4(float friction, float *v, float *angle, int lanes) {
+			typedef simd::Sse2 V;
+			__m128 update = V::FromMask(lanes);
+
+			// SoA of velocities
+			__m128 v01 = _mm_loadu_ps(v);
+			__m128 v23 = _mm_loadu_ps(v + 4);
+			__m128 x = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 y = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+			__m128 w = _mm_loadu_ps(angle);
+			__m128 rx = x;
+			__m128 ry = y;
+			simd::Friction<V>(V::Set(friction), w, rx, ry);
+
+			// Stopped stones have no angular velocity
+			__m128 stop = V::And(update,
+				V::CmpEq(V::Add(V::Mul(rx, rx), V::Mul(ry, ry)), V::Zero()));
+			w = V::AndNot(stop, w);
+
+			// Write back updated lanes
+			rx = V::Select(update, rx, x);
+			ry = V::Select(update, ry, y);
+			_mm_storeu_ps(v, _mm_unpacklo_ps(rx, ry));
+			_mm_storeu_ps(v + 4, _mm_unpackhi_ps(rx, ry));
+			_mm_storeu_ps(angle, w);
+
+			return V::Mask(stop);
+		}
+#endif // b2_useSSE2
+
 		// Add friction to all stones
+		//  Stones are taken from slot table of the world (all stones are in it).
+		//  Stopped stones get zero velocities, so they need not be woken.
+		//  Parked stones are skipped, and a stone is parked again when it stops.
+		//  Stones which are still moving after friction are set to board.moving_
+		//  (a stone woken by a hit is awake and has velocity here), and stones
+		//  which were awake before friction (moved in the last step) to board.awake_.
+		//  4 stones are processed at once with SSE2 if available.
 		void FrictionAll(float friction, Board &board) {
-			b2Vec2 vec;
+			const b2BodySlots &slots = board.world_.GetBodySlots();
+			unsigned int moving = 0;
+			unsigned int awake = 0;
+			int i = 0;
+
+#ifdef b2_useSSE2
+			for (; i < slots.count && i + 4 <= slots.capacity; i += 4) {
+				// Gather velocities of awake stones in 4 slots
+				int lanes = 0;
+				b2Vec2 v[4];
+				float w[4];
+				for (int j = 0; j < 4; j++) {
+					b2Body *body = slots.bodies[i + j];
+					if (body != nullptr && body->IsAwake()) {
+						lanes |= 1 << j;
+						v[j] = body->GetLinearVelocity();
+						w[j] = body->GetAngularVelocity();
+					}
+					else {
+						v[j].SetZero();
+						w[j] = 0.0f;
+					}
+				}
+				if (lanes == 0) {
+					continue;
+				}
+
+				int stopped = FrictionStep4(friction, &v[0].x, w, lanes);
+				for (int j = 0; j < 4; j++) {
+					if (lanes & (1 << j)) {
+						b2Body *body = slots.bodies[i + j];
+						body->SetLinearVelocity(v[j]);
+						body->SetAngularVelocity(w[j]);
+						awake |= 1u << StoneIndex(body);
+						if (stopped & (1 << j)) {
+							if (kParkStones) {
+								body->SetAwake(false);
+							}
+						}
+						else {
+							moving |= 1u << StoneIndex(body);
+						}
+					}
+				}
+			}
+#endif // b2_useSSE2
 
 			// Add friction to each stones in board
-			for (unsigned int i = 0; i < board.shot_num_ + 1; i++) {
-				if (board.body_[i] != nullptr) {
-					vec = FrictionStep(
+			for (; i < slots.count; i++) {
+				b2Body *body = slots.bodies[i];
+				if (body != nullptr && body->IsAwake()) {
+					awake |= 1u << StoneIndex(body);
+					b2Vec2 vec = FrictionStep(
 						friction, 
-						board.body_[i]->GetLinearVelocity(), 
-						board.body_[i]->GetAngularVelocity());
-					board.body_[i]->SetLinearVelocity(vec);
+						body->GetLinearVelocity(), 
+						body->GetAngularVelocity());
+					body->SetLinearVelocity(vec);
 					if (vec.Length() == 0) {
-						board.body_[i]->SetAngularVelocity(0.0f);
+						body->SetAngularVelocity(0.0f);
+						if (kParkStones) {
+							body->SetAwake(false);
+						}
+					}
+					else {
+						moving |= 1u << StoneIndex(body);
 					}
 				}
 			}
-		}
 
-		// Main loop for simulation
-		int MainLoop(const float time_step, const int loop_count, Board &board) {
-			int num_steps;
+			board.moving_ = moving;
+			board.awake_ = awake;
+		}
 
-			// Add friction 0.5 step at first
-			FrictionAll(kStoneFriction * time_step * 0.5f, board);
+		// Policies of MainLoop
+		//  Each policy is called in the step loop and the loop is compiled for
+		//  the combination, so disabled options cost nothing.
+		//    Recorder : Record(board, num_steps) after each step
+		//    Counter  : Count(world) after each step
+		//    Rule     : Step(board) after each step, Finish(board) after the loop
+		//    Limit    : Continue(board, num_steps) before each step
+
+		// Recorder which records nothing
+		struct NoRecord {
+			void Record(const Board &, int) {}
+		};
 
-			for (num_steps = 0; num_steps < loop_count || loop_count == -1; num_steps++) {
-				// Calclate friction
-				board.world_.Step(time_step, kVelocityIterations, kPositionIterations);
-				FrictionAll(kStoneFriction * time_step, board);
+		// Recorder of positions to trajectory array
+		class TrajectoryRecord {
+		public:
+			TrajectoryRecord(float *trajectory, size_t traj_size) : trajectory_(trajectory), traj_size_(traj_size) {}
 
-				// Check state of each stone
-				for (unsigned int i = 0; i < board.shot_num_ + 1; i++) {
+			void Record(const Board &board, int num_steps) {
+				b2Vec2 vec;
+				for (unsigned int i = 0; i < board.shot_num_ + 1 && i < traj_size_; i++) {
 					if (board.body_[i] != nullptr) {
-						b2Vec2 vec = board.body_[i]->GetLinearVelocity();
-						// Get area of stone
-						int area = GetStoneArea(board.body_[i]->GetPosition());
-						if (area == OUT_OF_RINK) {
-							//  Destroy body if a stone is out from Rink
-							board.world_.DestroyBody(board.body_[i]);
-							board.body_[i] = nullptr;
-						}
-						else if (vec.x != 0.0f || vec.y != 0.0f) {
-							// Continue first loop if a stone is awake
-							break;
-						}
+						vec = board.body_[i]->GetPosition();
+						trajectory_[num_steps * 32 + i] = vec.x;
+						trajectory_[num_steps * 32 + i + 1] = vec.y;
 					}
-					if (i == board.shot_num_) {
-						// Break first loop if all stone is stopped
-						goto LOOP_END;
+					else {
+						trajectory_[num_steps * 32 + i] = vec.x;
+						trajectory_[num_steps * 32 + i + 1] = vec.y;
 					}
 				}
 			}
 
-			LOOP_END:
+		private:
+			float *trajectory_;
+			size_t traj_size_;
+		};
 
-			// Remove delivered stone if not in playarea
-			if (board.body_[board.shot_num_] != nullptr) {
-				// Get area of stone
-				int area = GetStoneArea(board.body_[board.shot_num_]->GetPosition());
-				if (!(area & IN_PLAYAREA)) {
-					//  Destroy body if a stone is out from playarea
-					board.world_.DestroyBody(board.body_[board.shot_num_]);
-					board.body_[board.shot_num_] = nullptr;
-				}
+		// Counter of islands and velocity iterations only (default, two adds per step)
+		struct IterationStats {
+			void Count(const b2World &world) {
+				const b2Profile &profile = world.GetProfile();
+				last_stats.islands += profile.islandCount;
+				last_stats.velocity_iterations += profile.velocityIterations;
 			}
+		};
 
-			return num_steps;
-		}
-
-		// Main loop for simulation (with recording trajectory)
-		int MainLoop_Trajectory(const float time_step, const int loop_count, Board &board, float *trajectory, size_t traj_size) {
-			int num_steps;
-
-			// Add friction 0.5 step at first
-			FrictionAll(kStoneFriction * time_step * 0.5f, board);
+		// Counter of statistics to last_stats
+		struct StepStats {
+			void Count(const b2World &world) {
+				CountStep(world);
+			}
+		};
 
-			for (num_steps = 0; num_steps < loop_count || loop_count == -1; num_steps++) {
-				// Calclate friction
-				board.world_.Step(time_step, kVelocityIterations, kPositionIterations);
-				FrictionAll(kStoneFriction * time_step, board);
+		// Call loop(counter) with StepStats if step_stats is enabled, otherwise with IterationStats
+		template <class Loop>
+		int WithCounter(Loop loop) {
+			return step_stats.load(std::memory_order_relaxed) ? loop(StepStats()) : loop(IterationStats());
+		}
 
-				// Record to trajectory array
-				if (trajectory != nullptr) {
-					b2Vec2 vec;
-					for (unsigned int i = 0; i < board.shot_num_ + 1 && i < traj_size; i++) {
-						if (board.body_[i] != nullptr) {
-							vec = board.body_[i]->GetPosition();
-							trajectory[num_steps * 32 + i] = vec.x;
-							trajectory[num_steps * 32 + i + 1] = vec.y;
-						}
-						else {
-							trajectory[num_steps * 32 + i] = vec.x;
-							trajectory[num_steps * 32 + i + 1] = vec.y;
-						}
+		// Rule of Rink
+		//  Stones out from Rink are removed in each step, and delivered stone
+		//  is removed if it is not in playarea after the loop.
+		struct RinkRule {
+			void Step(Board &board) {
+				// Only stones awake in the step can leave Rink
+				//  (including stones stopped by friction of the step)
+				for (unsigned int awake = board.awake_; awake != 0; awake &= awake - 1) {
+					unsigned int i = LowestBit(awake);
+					if (GetStoneArea(board.body_[i]->GetPosition()) == OUT_OF_RINK) {
+						//  Destroy body if a stone is out from Rink
+						board.RemoveStone(i);
 					}
 				}
+			}
 
-				// Check state of each stone
-				for (unsigned int i = 0; i < board.shot_num_ + 1; i++) {
-					if (board.body_[i] != nullptr) {
-						b2Vec2 vec = board.body_[i]->GetLinearVelocity();
-						// Get area of stone
-						int area = GetStoneArea(board.body_[i]->GetPosition());
-						if (area == OUT_OF_RINK) {
-							//  Destroy body if a stone is out from Rink
-							board.world_.DestroyBody(board.body_[i]);
-							board.body_[i] = nullptr;
-						}
-						else if (vec.x != 0.0f || vec.y != 0.0f) {
-							// Continue first loop if a stone is awake
-							break;
-						}
-					}
-					if (i == board.shot_num_) {
-						// Break first loop if all stone is stopped
-						goto LOOP_END;
+			void Finish(Board &board) {
+				// Remove delivered stone if not in playarea
+				if (board.body_[board.shot_num_] != nullptr) {
+					// Get area of stone
+					int area = GetStoneArea(board.body_[board.shot_num_]->GetPosition());
+					if (!(area & IN_PLAYAREA)) {
+						//  Destroy body if a stone is out from playarea
+						board.RemoveStone(board.shot_num_);
 					}
 				}
 			}
+		};
+
+		// Limit which runs until all stones are stopped
+		struct UntilStopped {
+			bool Continue(const Board &, int) const { return true; }
+		};
+
+		// Limit of num of steps (loop_count in Simulation())
+		class StepLimit {
+		public:
+			explicit StepLimit(int loop_count) : loop_count_(loop_count) {}
+
+			bool Continue(const Board &, int num_steps) const { return num_steps < loop_count_; }
+
+		private:
+			int loop_count_;
+		};
+
+		// Limit which stops before delivered stone first touches another stone
+		//  State of delivered stone is kept before each step, so it is the state
+		//  before the step of first contact when the loop is stopped.
+		class UntilContact {
+		public:
+			explicit UntilContact(ShotSnapshot *snapshot) : snapshot_(snapshot) {}
+
+			bool Continue(const Board &board, int num_steps) {
+				if (board.IsTouching(board.shot_num_)) {
+					snapshot_->contact = true;
+					return false;
+				}
+				const b2Body *body = board.body_[board.shot_num_];
+				if (body != nullptr) {
+					const b2Vec2 &position = body->GetPosition();
+					const b2Vec2 &velocity = body->GetLinearVelocity();
+					snapshot_->position[0] = position.x;
+					snapshot_->position[1] = position.y;
+					snapshot_->velocity[0] = velocity.x;
+					snapshot_->velocity[1] = velocity.y;
+					snapshot_->angular_velocity = body->GetAngularVelocity();
+				}
+				snapshot_->steps = num_steps;
+				return true;
+			}
+
+		private:
+			ShotSnapshot *snapshot_;
+		};
 
-		LOOP_END:
+		// Steps of main loop from num_steps (> 0 if resumed from a snapshot)
+		template <class Recorder, class Counter, class Rule, class Limit>
+		int StepLoop(const float time_step, Board &board, Recorder recorder, Counter counter, Rule rule, Limit limit,
+			int num_steps) {
+			for (; limit.Continue(board, num_steps); num_steps++) {
+				// Calclate friction
+				board.world_.Step(time_step, kVelocityIterations, kPositionIterations);
+				counter.Count(board.world_);
+				FrictionAll(kStoneFriction * time_step, board);
 
-			// Remove delivered stone if not in playarea
-			if (board.body_[board.shot_num_] != nullptr) {
-				// Get area of stone
-				int area = GetStoneArea(board.body_[board.shot_num_]->GetPosition());
-				if (!(area & IN_PLAYAREA)) {
-					//  Destroy body if a stone is out from playarea
-					board.world_.DestroyBody(board.body_[board.shot_num_]);
-					board.body_[board.shot_num_] = nullptr;
+				recorder.Record(board, num_steps);
+				rule.Step(board);
+
+				// Break loop if all stones are stopped
+				if (board.moving_ == 0) {
+					break;
 				}
 			}
 
+			rule.Finish(board);
+
 			return num_steps;
 		}
 
+		// Main loop for simulation
+		//  returns num of steps until all stones are stopped (or limit)
+		template <class Recorder, class Counter, class Rule, class Limit>
+		int MainLoop(const float time_step, Board &board, Recorder recorder, Counter counter, Rule rule, Limit limit) {
+			// Add friction 0.5 step at first
+			FrictionAll(kStoneFriction * time_step * 0.5f, board);
+
+			return StepLoop(time_step, board, recorder, counter, rule, limit, 0);
+		}
+
 		// Check Freeguard rule
 		//  returns true if stone is removed in freeguard
 		bool IsFreeguardFoul(
@@ -413,6 +708,50 @@ namespace digital_curling {
 				}
 			}
 
+			UpdateTurn(game_state);
+		}
+
+		// Update game_state from board after simulation
+		//  returns false if shot was canceled by freeguard zone rule
+		bool ApplyBoard(const Board &board, GameState* const game_state) {
+			if (IsFreeguardFoul(board, game_state)) {
+				game_state->ShotNum++;
+				game_state->WhiteToMove ^= 1;
+				return false;
+			}
+
+			UpdateState(board, game_state);
+			return true;
+		}
+
+		// Update game_state with positions of stones after simulation
+		bool ApplyShot(GameState* const game_state, const float (*body)[2]) {
+			// Check freeguard zone rule (same as IsFreeguardFoul)
+			if (game_state->ShotNum < kNumFreeguard) {
+				for (unsigned int i = 0; i < game_state->ShotNum; i++) {
+					int area_before = GetStoneArea(b2Vec2(game_state->body[i][0], game_state->body[i][1]));
+					int area_after = GetStoneArea(b2Vec2(body[i][0], body[i][1]));
+					if ((area_before & area_freeguard) && !(area_after & IN_PLAYAREA)) {
+						game_state->ShotNum++;
+						game_state->WhiteToMove ^= 1;
+						return false;
+					}
+				}
+			}
+
+			// Update ShotNum and positions (same as UpdateState)
+			game_state->ShotNum++;
+			for (unsigned int i = 0; i < game_state->ShotNum; i++) {
+				game_state->body[i][0] = body[i][0];
+				game_state->body[i][1] = body[i][1];
+			}
+
+			UpdateTurn(game_state);
+			return true;
+		}
+
+		// Update Score and WhiteToMove (ShotNum is already updated)
+		void UpdateTurn(GameState* const game_state) {
 			// Update Score if ShotNum == 16
 			if (game_state->ShotNum == 16) {
 				// Calculate Socre
@@ -433,6 +772,13 @@ namespace digital_curling {
 			}
 		}
 
+		// Check ShotNum, CurEnd and LastEnd of GameState received from outside
+		bool IsValidState(const GameState &game_state) {
+			return game_state.ShotNum <= 16 &&
+				game_state.CurEnd < kLastEndMax &&
+				game_state.LastEnd <= kLastEndMax;
+		}
+
 		// Simulation with Box2D (compatible with Simulation() in CurlingSimulator.h)
 		int Simulation(
 			GameState* const game_state, 
@@ -452,31 +798,139 @@ namespace digital_curling {
 				memcpy_s(run_shot, sizeof(ShotVec), &shot_vec, sizeof(ShotVec));
 			}
 
+			return SimulateShot(game_state, shot_vec, trajectory, traj_size);
+		}
+
+		// Run a job of simulation
+		void RunJob(const SimJob &job, SimResult* const result) {
+			result->id = job.id;
+			result->game_state = job.game_state;
+			result->run_shot = job.shot_vec;
+
+			if (job.game_state.ShotNum > 15 || !IsValidState(job.game_state)) {
+				result->steps = -1;
+				return;
+			}
+
+			// Add random number to shot (reproducible if seed != 0)
+			if (job.seed != 0) {
+				std::default_random_engine engine(job.seed);
+				AddRandom2Vec(job.random_x, job.random_y, &result->run_shot, engine);
+			}
+			else {
+				AddRandom2Vec(job.random_x, job.random_y, &result->run_shot);
+			}
+
+			result->steps = SimulateShot(&result->game_state, result->run_shot, nullptr, 0);
+		}
+
+		// Simulate shot_vec (random number is already added)
+		int SimulateShot(
+			GameState* const game_state,
+			const ShotVec &shot_vec,
+			float *trajectory, size_t traj_size) {
+
+			ResetStats();
+			HeapCounter heap_counter;
+
+			// Use outcome in cache if exists (trajectory is not cached)
+			int steps;
+			if (trajectory == nullptr && LookupOutcome(game_state, shot_vec, &steps)) {
+				return steps;
+			}
+			GameState game_state_before = *game_state;
+
 			// Create board
 			Board board(*game_state, shot_vec);
 
 			// Run mainloop of simulation
-			int steps;
 			if (trajectory != nullptr) {
-				steps = MainLoop_Trajectory(kTimeStep, -1, board, trajectory, traj_size);
+				steps = WithCounter([&](auto counter) {
+					return MainLoop(kTimeStep, board,
+						TrajectoryRecord(trajectory, traj_size), counter, RinkRule(), UntilStopped());
+				});
 			}
 			else {
-				steps = MainLoop(kTimeStep, -1, board);
+				steps = WithCounter([&](auto counter) {
+					return MainLoop(kTimeStep, board,
+						NoRecord(), counter, RinkRule(), UntilStopped());
+				});
 			}
 
-			// Check freeguard zone rule
-			if (IsFreeguardFoul(board, game_state)) {
-				game_state->ShotNum++;
-				game_state->WhiteToMove ^= 1;
-				return 0;
+			// Check freeguard zone rule and update game_state
+			bool foul = !ApplyBoard(board, game_state);
+			if (foul) {
+				steps = 0;
 			}
 
-			// Update game_state
-			UpdateState(board, game_state);
+			// Store outcome to cache
+			StoreOutcome(game_state_before, shot_vec, *game_state, steps, foul);
 
 			return steps;
 		}
 
+		// Simulate shot until delivered stone first touches another stone
+		bool SimulateUntilFirstContact(
+			const GameState &game_state, const ShotVec &run_shot, ShotSnapshot* const snapshot) {
+			*snapshot = ShotSnapshot();
+			if (game_state.ShotNum > 15) {
+				return false;
+			}
+
+			ResetStats();
+			HeapCounter heap_counter;
+
+			Board board(game_state, run_shot);
+			int steps = WithCounter([&](auto counter) {
+				return MainLoop(kTimeStep, board,
+					NoRecord(), counter, RinkRule(), UntilContact(snapshot));
+			});
+
+			if (!snapshot->contact) {
+				// Shot ended without contact (delivered stone is stopped or removed)
+				const b2Body *body = board.body_[board.shot_num_];
+				snapshot->position[0] = (body != nullptr) ? body->GetPosition().x : 0.0f;
+				snapshot->position[1] = (body != nullptr) ? body->GetPosition().y : 0.0f;
+				snapshot->velocity[0] = snapshot->velocity[1] = 0.0f;
+				snapshot->angular_velocity = 0.0f;
+				snapshot->steps = steps;
+			}
+			snapshot->time = snapshot->steps * kTimeStep;
+
+			return snapshot->contact;
+		}
+
+		// Finish shot from snapshot
+		int ResumeFrom(const ShotSnapshot &snapshot, GameState* const game_state) {
+			if (game_state->ShotNum > 15) {
+				return -1;
+			}
+
+			ResetStats();
+
+			// Only delivered stone has moved (same as UpdateState)
+			if (!snapshot.contact) {
+				float body[16][2];
+				memcpy(body, game_state->body, sizeof(body));
+				body[game_state->ShotNum][0] = snapshot.position[0];
+				body[game_state->ShotNum][1] = snapshot.position[1];
+				return ApplyShot(game_state, body) ? snapshot.steps : 0;
+			}
+
+			HeapCounter heap_counter;
+
+			// Run the step of first contact and following steps
+			Board board(*game_state,
+				b2Vec2(snapshot.position[0], snapshot.position[1]),
+				b2Vec2(snapshot.velocity[0], snapshot.velocity[1]), snapshot.angular_velocity);
+			int steps = WithCounter([&](auto counter) {
+				return StepLoop(kTimeStep, board,
+					NoRecord(), counter, RinkRule(), UntilStopped(), snapshot.steps);
+			});
+
+			return ApplyBoard(board, game_state) ? steps : 0;
+		}
+
 		// ?
 		b2Vec2 CreateShot(float x, float y)
 		{
@@ -520,6 +974,11 @@ namespace digital_curling {
 			std::random_device seed_gen;
 			std::default_random_engine engine(seed_gen());
 
+			AddRandom2Vec(random_x, random_y, vec, engine);
+		}
+
+		// Add random number to ShotVec with given random engine
+		void AddRandom2Vec(float random_x, float random_y, ShotVec* const vec, std::default_random_engine &engine) {
 			ShotPos tee_pos(kCenterX, kTeeY, vec->angle);
 			ShotVec tee_shot, add_rand_tee_shot;
 
@@ -80,6 +80,67 @@ namespace digital_curling {
 			bool angle;
 		};
 
+		// Job of simulation (plain data to be passed between threads or processes)
+		class DLLEXP SimJob {
+		public:
+			unsigned long long id;   // Any number to identify the job (copied to SimResult)
+			GameState game_state;    // GameState before shot
+			ShotVec shot_vec;        // Shot without random number
+			float random_x;          // Random number for shot (same as Simulation())
+			float random_y;
+			unsigned int seed;       // Seed of random number (0: non-deterministic)
+		};
+
+		// Result of SimJob
+		class DLLEXP SimResult {
+		public:
+			unsigned long long id;   // id of SimJob
+			GameState game_state;    // GameState after shot
+			ShotVec run_shot;        // Shot with random number
+			int steps;               // Return value of Simulation()
+		};
+
+		// Statistics of a simulation
+		class DLLEXP SimStats {
+		public:
+			// Counted only if EnableStepStats(true) (0 otherwise), except islands and
+			// velocity_iterations which are always counted
+			int steps;                 // Steps of world (0 if outcome was in cache)
+			int islands;               // Islands solved (sum over steps)
+			int velocity_iterations;   // Velocity iterations (sum over islands)
+			int gjk_calls;             // Distance queries of Box2D
+			int gjk_iterations;        // GJK iterations of distance queries (0 for two stones)
+			int toi_calls;             // Time of impact queries of Box2D (continuous collision)
+			int toi_iterations;        // Iterations of time of impact (0 for two stones)
+			// Always recorded
+			int stack_bytes;           // High-water mark of per step memory of the world
+			int stack_fallbacks;       // Per step allocations which did not fit the stack memory
+			int block_chunks;          // Chunks of block allocator of the world
+			int arena_bytes;           // Memory of the world in the arena (0 if on the heap)
+			int heap_allocations;      // Heap allocations of Box2D (0 after warm-up)
+			int heap_bytes;            // Bytes of heap allocations
+			int heap_peak_bytes;       // High-water mark of heap memory in use (from the start)
+			int simd_path;             // Instruction set of vectorized kernels (b2simulator::SimdPath)
+
+			// Average of velocity iterations per island
+			float AverageVelocityIterations() const {
+				return (islands > 0) ? static_cast<float>(velocity_iterations) / islands : 0.0f;
+			}
+		};
+
+		// State of a shot at the step before first contact (SimulateUntilFirstContact())
+		//  Only the delivered stone moves until it touches another stone,
+		//  so other stones are still at their positions in GameState.
+		class DLLEXP ShotSnapshot {
+		public:
+			float position[2];       // Position of delivered stone ((0, 0) if removed)
+			float velocity[2];       // Linear velocity of delivered stone
+			float angular_velocity;  // Angular velocity of delivered stone
+			float time;              // Simulated time (sec)
+			int steps;               // Steps simulated
+			bool contact;            // false if shot ended without contact
+		};
+
 		// Simulator with Box2D 2.3.0 (http://box2d.org/)
 		namespace b2simulator {
 
@@ -90,12 +151,74 @@ namespace digital_curling {
 				float random_x, float random_y, 
 				ShotVec* const run_shot, float *trajectory, size_t traj_size);
 
+			// Run a job of simulation (same as Simulation() without trajectory)
+			//  steps of result is -1 if ShotNum > 15, CurEnd >= kLastEndMax or LastEnd > kLastEndMax
+			DLLEXP void RunJob(const SimJob &job, SimResult* const result);
+
+			// Run jobs in parallel (results[i] is the result of jobs[i])
+			//  num_threads : num of threads (0: num of cores)
+			DLLEXP void RunJobs(const SimJob *jobs, SimResult *results, size_t count, unsigned int num_threads);
+
+			// Simulate shots from a GameState in lockstep (a board per SIMD lane)
+			//  Boards are advanced together step by step, and a lane takes next shot
+			//  when its board stops. Collisions are solved with a circle model of stones
+			//  instead of Box2D, so results are close to (not same as) Simulation().
+			//  run_shots   : shots with random number (e.g. by AddRandom2Vec())
+			//  results     : GameState after each shot
+			//  steps       : num of steps of each shot (may be nullptr)
+			//  num_threads : num of threads (0: num of cores)
+			//  If ShotNum of game_state is 16 or more, results are game_state and steps are -1.
+			DLLEXP void SimulateLockstep(
+				const GameState &game_state, const ShotVec *run_shots, size_t count,
+				GameState *results, int *steps, unsigned int num_threads);
+
+			// Simulate shot until delivered stone first touches another stone
+			//  Shots from the same GameState share the approach until first contact,
+			//  so search can keep snapshots and finish them by ResumeFrom().
+			//  (outcome cache is not used)
+			//  run_shot : shot with random number (e.g. by AddRandom2Vec())
+			//  snapshot : state at the step before first contact,
+			//             or at the end of shot if it ended without contact
+			//  returns true if stopped before contact
+			DLLEXP bool SimulateUntilFirstContact(
+				const GameState &game_state, const ShotVec &run_shot, ShotSnapshot* const snapshot);
+
+			// Finish shot from snapshot
+			//  The world is rebuilt at the snapshot, so results are the same as Simulation()
+			//  of the shot except when order of contacts of the delivered stone matters
+			//  (e.g. it touches two stones in a step), then they differ in the last bits.
+			//  game_state : GameState given to SimulateUntilFirstContact(), updated
+			//  returns number of steps of whole shot
+			DLLEXP int ResumeFrom(const ShotSnapshot &snapshot, GameState* const game_state);
+
 			// Create ShotVec from ShotPos which a stone will stop at
 			DLLEXP void CreateShot(ShotPos pos, ShotVec* const vec);
 
 			// Add random number to ShotVec (normal distribution)
 			DLLEXP void AddRandom2Vec(float random_x, float random_y, ShotVec* const vec);
 
+			// Get statistics of the last Simulation() / RunJob() / SimulateLockstep() in calling thread
+			DLLEXP void GetLastSimStats(SimStats* const stats);
+
+			// Enable statistics of each step (steps, GJK / TOI queries)
+			//  Disabled by default, then the main loop counts only islands and iterations.
+			//  Can be called from any thread; applies to simulations started afterwards.
+			DLLEXP void EnableStepStats(bool enable);
+
+			// Instruction set of vectorized kernels
+			DLLEXP typedef enum {
+				SIMD_SCALAR = 0,
+				SIMD_SSE2,
+				SIMD_SSE42,
+				SIMD_AVX2,
+				SIMD_AVX512
+			} SimdPath;
+
+			// Get instruction set selected for CPU (used by SimulateLockstep())
+			//  Simulation() uses vector types of the build (SSE2 on x86).
+			//  SIMD_AVX512 is not selected if built with Visual C++ older than VS 2017 15.3.
+			DLLEXP SimdPath GetSimdPath();
+
 			// Return score of second (which has last shot in this end)
 			DLLEXP int GetScore(const GameState* const game_state);
 
@@ -112,6 +235,17 @@ namespace digital_curling {
 			DLLEXP void SetOptions(unsigned int shot_num, StoneArea area);
 			// Set options to default
 			DLLEXP void SetOptions();
+
+			// Open outcome cache file shared between processes
+			//  Outcomes of Simulation() without trajectory are looked up from / stored to this file.
+			//  The file is recreated if it was made with other physics constants or num_entries.
+			//  returns false if the file could not be opened (simulation works without cache)
+			//  Note: Call this before starting simulation in other threads
+			DLLEXP bool OpenOutcomeCache(const char *path, unsigned int num_entries);
+			// Close outcome cache file
+			DLLEXP void CloseOutcomeCache();
+			// Get number of hits / misses of outcome cache in this process
+			DLLEXP void GetOutcomeCacheStats(unsigned long long *hits, unsigned long long *misses);
 		}
 
 		// Operators
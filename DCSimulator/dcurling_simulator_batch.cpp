@@ -0,0 +1,56 @@
+// Batch execution of simulation
+#include "dcurling_simulator.h"
+#include "dcurling_simulator_internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr size_t kParallelChunk = 16;  // Num of items taken by a thread at once
+
+		// Call func(i) for i in [0, count) on num_threads threads
+		void ParallelFor(size_t count, unsigned int num_threads, const std::function<void(size_t)> &func) {
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			size_t num_chunks = (count + kParallelChunk - 1) / kParallelChunk;
+			num_threads = static_cast<unsigned int>(std::min<size_t>(num_threads, num_chunks));
+
+			std::atomic<size_t> next(0);
+			auto run = [&]() {
+				for (;;) {
+					size_t begin = next.fetch_add(kParallelChunk);
+					if (begin >= count) {
+						break;
+					}
+					size_t end = std::min(begin + kParallelChunk, count);
+					for (size_t i = begin; i < end; i++) {
+						func(i);
+					}
+				}
+			};
+
+			// Calling thread also works
+			std::vector<std::thread> threads;
+			for (unsigned int i = 1; i < num_threads; i++) {
+				threads.emplace_back(run);
+			}
+			run();
+			for (auto &t : threads) {
+				t.join();
+			}
+		}
+
+		// Run jobs in parallel
+		void RunJobs(const SimJob *jobs, SimResult *results, size_t count, unsigned int num_threads) {
+			ParallelFor(count, num_threads, [&](size_t i) {
+				RunJob(jobs[i], &results[i]);
+			});
+		}
+	}
+}
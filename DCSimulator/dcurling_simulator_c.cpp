@@ -0,0 +1,157 @@
+// C interface of the simulator
+#include "dcurling_simulator_c.h"
+#include "dcurling_simulator.h"
+#include "dcurling_simulator_internal.h"
+
+#include <atomic>
+#include <type_traits>
+
+namespace {
+
+	using digital_curling::GameState;
+	using digital_curling::ShotPos;
+	using digital_curling::ShotVec;
+
+	// Pointer to i th element of strided array
+	template <class T>
+	inline T *Element(T *base, ptrdiff_t stride, size_t i) {
+		typedef typename std::conditional<std::is_const<T>::value, const char, char>::type Byte;
+		return reinterpret_cast<T*>(reinterpret_cast<Byte*>(base) + stride * static_cast<ptrdiff_t>(i));
+	}
+
+	// Read GameState from flat arrays
+	//  returns false if ShotNum, CurEnd or LastEnd is out of range
+	bool ReadState(const float *body, const int32_t *info, GameState *gs) {
+		for (unsigned int i = 0; i < 16; i++) {
+			gs->body[i][0] = body[2 * i];
+			gs->body[i][1] = body[2 * i + 1];
+		}
+		gs->ShotNum = info[0];
+		gs->CurEnd = info[1];
+		gs->LastEnd = info[2];
+		gs->WhiteToMove = (info[3] != 0);
+		return digital_curling::b2simulator::IsValidState(*gs);
+	}
+
+	// Write GameState to flat arrays
+	void WriteState(const GameState &gs, float *body, int32_t *info) {
+		for (unsigned int i = 0; i < 16; i++) {
+			body[2 * i] = gs.body[i][0];
+			body[2 * i + 1] = gs.body[i][1];
+		}
+		info[0] = gs.ShotNum;
+		info[1] = gs.CurEnd;
+		info[2] = gs.LastEnd;
+		info[3] = gs.WhiteToMove ? 1 : 0;
+		info[4] = (gs.CurEnd < digital_curling::kLastEndMax) ? gs.Score[gs.CurEnd] : 0;
+	}
+}
+
+extern "C" {
+
+	int dcs_abi_version(void) {
+		return DCS_ABI_VERSION;
+	}
+
+	int dcs_simulate_batch(
+		size_t count,
+		const float *bodies, ptrdiff_t bodies_stride,
+		const int32_t *infos, ptrdiff_t infos_stride,
+		const float *shots, ptrdiff_t shots_stride,
+		const uint32_t *seeds, ptrdiff_t seeds_stride,
+		float random_x, float random_y,
+		float *out_bodies, ptrdiff_t out_bodies_stride,
+		int32_t *out_infos, ptrdiff_t out_infos_stride,
+		float *out_shots, ptrdiff_t out_shots_stride,
+		int32_t *out_steps, ptrdiff_t out_steps_stride,
+		unsigned int num_threads) {
+		using namespace digital_curling;
+
+		if (bodies == nullptr || infos == nullptr || shots == nullptr ||
+			out_bodies == nullptr || out_infos == nullptr) {
+			return -1;
+		}
+
+		std::atomic<bool> invalid(false);
+		b2simulator::ParallelFor(count, num_threads, [&](size_t i) {
+			SimJob job;
+			SimResult result;
+
+			bool valid = ReadState(Element(bodies, bodies_stride, i), Element(infos, infos_stride, i), &job.game_state);
+			const float *shot = Element(shots, shots_stride, i);
+			job.shot_vec = ShotVec(shot[0], shot[1], shot[2] != 0.0f);
+			job.random_x = random_x;
+			job.random_y = random_y;
+			job.seed = (seeds != nullptr) ? *Element(seeds, seeds_stride, i) : 0;
+
+			if (valid && job.game_state.ShotNum <= 15) {
+				b2simulator::RunJob(job, &result);
+			}
+			else {
+				// Not simulated (outputs are copy of inputs)
+				invalid = true;
+				result.game_state = job.game_state;
+				result.run_shot = job.shot_vec;
+				result.steps = -1;
+			}
+
+			WriteState(result.game_state, Element(out_bodies, out_bodies_stride, i), Element(out_infos, out_infos_stride, i));
+			if (out_shots != nullptr) {
+				float *out_shot = Element(out_shots, out_shots_stride, i);
+				out_shot[0] = result.run_shot.x;
+				out_shot[1] = result.run_shot.y;
+				out_shot[2] = result.run_shot.angle ? 1.0f : 0.0f;
+			}
+			if (out_steps != nullptr) {
+				*Element(out_steps, out_steps_stride, i) = result.steps;
+			}
+		});
+
+		return invalid ? -2 : 0;
+	}
+
+	int dcs_create_shot_batch(
+		size_t count,
+		const float *positions, ptrdiff_t positions_stride,
+		float *out_shots, ptrdiff_t out_shots_stride) {
+		if (positions == nullptr || out_shots == nullptr) {
+			return -1;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			const float *position = Element(positions, positions_stride, i);
+			ShotVec vec;
+			digital_curling::b2simulator::CreateShot(ShotPos(position[0], position[1], position[2] != 0.0f), &vec);
+			float *out_shot = Element(out_shots, out_shots_stride, i);
+			out_shot[0] = vec.x;
+			out_shot[1] = vec.y;
+			out_shot[2] = vec.angle ? 1.0f : 0.0f;
+		}
+
+		return 0;
+	}
+
+	int dcs_get_score_batch(
+		size_t count,
+		const float *bodies, ptrdiff_t bodies_stride,
+		const int32_t *infos, ptrdiff_t infos_stride,
+		int32_t *out_scores, ptrdiff_t out_scores_stride) {
+		if (bodies == nullptr || infos == nullptr || out_scores == nullptr) {
+			return -1;
+		}
+
+		int ret = 0;
+		for (size_t i = 0; i < count; i++) {
+			GameState gs;
+			if (ReadState(Element(bodies, bodies_stride, i), Element(infos, infos_stride, i), &gs)) {
+				*Element(out_scores, out_scores_stride, i) = digital_curling::b2simulator::GetScore(&gs);
+			}
+			else {
+				*Element(out_scores, out_scores_stride, i) = 0;
+				ret = -2;
+			}
+		}
+
+		return ret;
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef DCURLING_SIMULATOR_C_H
+#define DCURLING_SIMULATOR_C_H
+
+/* C interface of the simulator for foreign callers (ctypes, cffi, ...)
+ *  Batches are passed as flat arrays owned by the caller.
+ *  Every array has a stride in bytes between elements, so rows of numpy arrays
+ *  can be passed without copy. Stride 0 uses the same element for all shots
+ *  (e.g. one GameState for a Monte Carlo batch).
+ *
+ *  Layout of elements
+ *      state body : float[32]  x0, y0, x1, y1, ... (same as GameState::body)
+ *      state info : int32[4]   ShotNum, CurEnd, LastEnd, WhiteToMove
+ *      shot       : float[3]   x, y, angle (0: false, otherwise true)
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DCS_API
+#ifdef _WIN32
+#define DCS_API __declspec(dllexport)
+#else /* _WIN32 */
+#define DCS_API
+#endif /* _WIN32 */
+#endif /* DCS_API */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define DCS_ABI_VERSION 1
+
+/* Number of elements of arrays */
+#define DCS_BODY_SIZE     32
+#define DCS_INFO_SIZE     4
+#define DCS_OUT_INFO_SIZE 5  /* DCS_INFO_SIZE and Score of CurEnd */
+#define DCS_SHOT_SIZE     3
+
+/* Return DCS_ABI_VERSION of the library */
+DCS_API int dcs_abi_version(void);
+
+/* Simulate a batch of shots
+ *  count         : num of shots
+ *  bodies, infos : GameState before shot
+ *  shots         : shots without random number
+ *  seeds         : seed of random number per shot (NULL or 0: non-deterministic)
+ *  random_x/y    : random number for all shots (same as Simulation())
+ *  out_bodies    : positions after shot
+ *  out_infos     : ShotNum, CurEnd, LastEnd, WhiteToMove, Score of CurEnd after shot
+ *  out_shots     : shots with random number (may be NULL)
+ *  out_steps     : return value of Simulation() (may be NULL)
+ *  num_threads   : num of threads (0: num of cores)
+ *  returns 0, -1 if required array is NULL,
+ *  or -2 if some states are invalid (ShotNum > 15, CurEnd >= 10 or LastEnd > 10)
+ *  Shots from invalid states are not simulated: out_steps is -1 and
+ *  other outputs are copy of inputs.
+ */
+DCS_API int dcs_simulate_batch(
+	size_t count,
+	const float *bodies, ptrdiff_t bodies_stride,
+	const int32_t *infos, ptrdiff_t infos_stride,
+	const float *shots, ptrdiff_t shots_stride,
+	const uint32_t *seeds, ptrdiff_t seeds_stride,
+	float random_x, float random_y,
+	float *out_bodies, ptrdiff_t out_bodies_stride,
+	int32_t *out_infos, ptrdiff_t out_infos_stride,
+	float *out_shots, ptrdiff_t out_shots_stride,
+	int32_t *out_steps, ptrdiff_t out_steps_stride,
+	unsigned int num_threads);
+
+/* Create shots from positions where stones will stop at
+ *  positions : float[3] x, y, angle per shot
+ *  returns 0, or -1 if array is NULL
+ */
+DCS_API int dcs_create_shot_batch(
+	size_t count,
+	const float *positions, ptrdiff_t positions_stride,
+	float *out_shots, ptrdiff_t out_shots_stride);
+
+/* Get score of second (same as GetScore()) for a batch of states
+ *  returns 0, -1 if array is NULL,
+ *  or -2 if some states are invalid (ShotNum > 16, CurEnd >= 10 or LastEnd > 10)
+ *  Score of invalid states is 0.
+ */
+DCS_API int dcs_get_score_batch(
+	size_t count,
+	const float *bodies, ptrdiff_t bodies_stride,
+	const int32_t *infos, ptrdiff_t infos_stride,
+	int32_t *out_scores, ptrdiff_t out_scores_stride);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* DCURLING_SIMULATOR_C_H */
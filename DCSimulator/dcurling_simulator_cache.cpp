@@ -0,0 +1,395 @@
+// Outcome cache shared between processes (file-backed hash table)
+//  Layout of file: CacheHeader, CacheSlot[num_slots]
+//  Slots are filled with open addressing and never removed.
+//  Each slot is published by its state (kSlotEmpty -> kSlotWriting -> kSlotReady),
+//  so readers in other processes see only completely written slots.
+#include "dcurling_simulator.h"
+#include "dcurling_simulator_internal.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr uint32_t kCacheMagic   = 0x43534344;  // "DCSC"
+		constexpr uint32_t kCacheFormat  = 1;           // Version of file layout
+		constexpr unsigned int kMaxProbe = 32;          // Max num of slots probed per lookup
+
+		// State of slot
+		constexpr uint32_t kSlotEmpty   = 0;
+		constexpr uint32_t kSlotWriting = 1;
+		constexpr uint32_t kSlotReady   = 2;
+
+		struct CacheHeader {
+			uint32_t magic;
+			uint32_t format;
+			uint64_t physics_hash;   // Hash of constants which affect results
+			uint64_t num_slots;
+			uint64_t reserved[5];
+		};
+
+		struct CacheKey {
+			float body[16][2];       // Positions of stones (0 for index >= shot_num)
+			float vec_x;             // ShotVec after random is added
+			float vec_y;
+			uint32_t angle;
+			uint32_t shot_num;
+			uint32_t num_freeguard;  // Options for freeguard zone rule
+			uint32_t area_freeguard;
+		};
+
+		struct CacheSlot {
+			std::atomic<uint32_t> state;
+			uint32_t hash;
+			CacheKey key;
+			float body[16][2];       // Positions of stones after simulation
+			int32_t steps;
+			uint32_t foul;
+		};
+
+		// Outcome cache opened in this process
+		struct OutcomeCache {
+			std::mutex mutex;        // Guards open / close
+			CacheHeader *header = nullptr;
+			CacheSlot *slots = nullptr;
+			uint64_t num_slots = 0;
+			size_t map_size = 0;
+#ifdef _WIN32
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#endif // _WIN32
+			std::atomic<unsigned long long> hits{ 0 };
+			std::atomic<unsigned long long> misses{ 0 };
+		} outcome_cache;
+
+		// FNV-1a hash
+		inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+			const unsigned char *p = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < size; i++) {
+				hash ^= p[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		// Hash of constants which affect results of simulation
+		uint64_t GetPhysicsHash() {
+			const float constants[] = {
+				kStoneR, kStoneDensity, kStoneResitution, kStoneFriction, kStandardAngle,
+				kPlayAreaXLeft, kPlayAreaXRight, kPlayAreaYTop, kPlayAreaYBottom,
+				kRinkYTop, kRinkYBottom, kHackY, kCenterX, kTeeY, kHouseR, kTimeStep
+			};
+			const uint32_t values[] = {
+				kVelocityIterations, kPositionIterations, kPhysicsRevision,
+				static_cast<uint32_t>(sizeof(CacheSlot))
+			};
+			return HashBytes(values, sizeof(values), HashBytes(constants, sizeof(constants)));
+		}
+
+		// Create key from GameState and ShotVec
+		void MakeKey(const GameState &gs, const ShotVec &vec, CacheKey *key) {
+			memset(key, 0x00, sizeof(CacheKey));
+			for (unsigned int i = 0; i < gs.ShotNum && i < 16; i++) {
+				key->body[i][0] = gs.body[i][0];
+				key->body[i][1] = gs.body[i][1];
+			}
+			key->vec_x = vec.x;
+			key->vec_y = vec.y;
+			key->angle = vec.angle ? 1 : 0;
+			key->shot_num = gs.ShotNum;
+			key->num_freeguard = num_freeguard;
+			key->area_freeguard = area_freeguard;
+		}
+
+		bool IsValidHeader(const CacheHeader *header, uint64_t num_slots) {
+			return header->magic == kCacheMagic &&
+				header->format == kCacheFormat &&
+				header->physics_hash == GetPhysicsHash() &&
+				header->num_slots == num_slots;
+		}
+
+		void InitHeader(CacheHeader *header, uint64_t num_slots) {
+			memset(header, 0x00, sizeof(CacheHeader));
+			header->magic = kCacheMagic;
+			header->format = kCacheFormat;
+			header->physics_hash = GetPhysicsHash();
+			header->num_slots = num_slots;
+		}
+
+		void CloseOutcomeCacheLocked() {
+			if (outcome_cache.header == nullptr) {
+				return;
+			}
+#ifdef _WIN32
+			UnmapViewOfFile(outcome_cache.header);
+			CloseHandle(outcome_cache.mapping);
+			CloseHandle(outcome_cache.file);
+			outcome_cache.mapping = nullptr;
+			outcome_cache.file = INVALID_HANDLE_VALUE;
+#else // _WIN32
+			munmap(outcome_cache.header, outcome_cache.map_size);
+#endif // _WIN32
+			outcome_cache.header = nullptr;
+			outcome_cache.slots = nullptr;
+			outcome_cache.num_slots = 0;
+			outcome_cache.map_size = 0;
+		}
+
+#ifdef _WIN32
+		// Open (and initialize if needed) cache file
+		bool MapCacheFile(const char *path, uint64_t num_slots, size_t map_size) {
+			HANDLE file = CreateFileA(
+				path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			// Lock file while checking header
+			OVERLAPPED overlapped = {};
+			if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+				CloseHandle(file);
+				return false;
+			}
+
+			CacheHeader header = {};
+			DWORD read_size = 0;
+			LARGE_INTEGER file_size;
+			bool valid = GetFileSizeEx(file, &file_size) &&
+				file_size.QuadPart == static_cast<LONGLONG>(map_size) &&
+				ReadFile(file, &header, sizeof(header), &read_size, nullptr) &&
+				read_size == sizeof(header) &&
+				IsValidHeader(&header, num_slots);
+			if (!valid) {
+				// Recreate file (fails if other process maps the file)
+				LARGE_INTEGER zero = {};
+				LARGE_INTEGER size;
+				size.QuadPart = static_cast<LONGLONG>(map_size);
+				InitHeader(&header, num_slots);
+				DWORD written = 0;
+				if (!SetFilePointerEx(file, zero, nullptr, FILE_BEGIN) || !SetEndOfFile(file) ||
+					!SetFilePointerEx(file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(file) ||
+					!SetFilePointerEx(file, zero, nullptr, FILE_BEGIN) ||
+					!WriteFile(file, &header, sizeof(header), &written, nullptr)) {
+					UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+					CloseHandle(file);
+					return false;
+				}
+			}
+
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+			void *addr = (mapping != nullptr) ?
+				MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, map_size) :
+				nullptr;
+			UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+			if (addr == nullptr) {
+				if (mapping != nullptr) {
+					CloseHandle(mapping);
+				}
+				CloseHandle(file);
+				return false;
+			}
+
+			outcome_cache.file = file;
+			outcome_cache.mapping = mapping;
+			outcome_cache.header = static_cast<CacheHeader*>(addr);
+			return true;
+		}
+#else // _WIN32
+		// Open (and initialize if needed) cache file
+		bool MapCacheFile(const char *path, uint64_t num_slots, size_t map_size) {
+			for (;;) {
+				int fd = open(path, O_RDWR | O_CREAT, 0666);
+				if (fd < 0) {
+					return false;
+				}
+
+				// Lock file while checking header
+				if (flock(fd, LOCK_EX) != 0) {
+					close(fd);
+					return false;
+				}
+
+				// Retry if the file was replaced by other process while waiting lock
+				struct stat st_fd, st_path;
+				if (fstat(fd, &st_fd) != 0 || stat(path, &st_path) != 0 ||
+					st_fd.st_ino != st_path.st_ino || st_fd.st_dev != st_path.st_dev) {
+					close(fd);
+					continue;
+				}
+
+				CacheHeader header = {};
+				bool valid = st_fd.st_size == static_cast<off_t>(map_size) &&
+					pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+					IsValidHeader(&header, num_slots);
+				if (!valid && st_fd.st_size != 0) {
+					// Other processes may map old file, so replace it with a new file
+					unlink(path);
+					close(fd);
+					continue;
+				}
+				if (!valid) {
+					InitHeader(&header, num_slots);
+					if (ftruncate(fd, static_cast<off_t>(map_size)) != 0 ||
+						pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+						close(fd);
+						return false;
+					}
+				}
+
+				void *addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				close(fd);  // Also releases lock
+				if (addr == MAP_FAILED) {
+					return false;
+				}
+
+				outcome_cache.header = static_cast<CacheHeader*>(addr);
+				return true;
+			}
+		}
+#endif // _WIN32
+
+		// Open outcome cache file shared between processes
+		bool OpenOutcomeCache(const char *path, unsigned int num_entries) {
+			std::lock_guard<std::mutex> lock(outcome_cache.mutex);
+
+			CloseOutcomeCacheLocked();
+			if (path == nullptr || num_entries == 0) {
+				return false;
+			}
+
+			// Slots are shared as raw memory, atomic must not use a lock
+			std::atomic<uint32_t> state_test;
+			if (!state_test.is_lock_free()) {
+				return false;
+			}
+
+			uint64_t num_slots = num_entries;
+			size_t map_size = sizeof(CacheHeader) + sizeof(CacheSlot) * num_slots;
+			if (!MapCacheFile(path, num_slots, map_size)) {
+				return false;
+			}
+			outcome_cache.slots = reinterpret_cast<CacheSlot*>(outcome_cache.header + 1);
+			outcome_cache.num_slots = num_slots;
+			outcome_cache.map_size = map_size;
+
+			return true;
+		}
+
+		// Close outcome cache file
+		void CloseOutcomeCache() {
+			std::lock_guard<std::mutex> lock(outcome_cache.mutex);
+
+			CloseOutcomeCacheLocked();
+		}
+
+		// Get number of hits / misses of outcome cache in this process
+		void GetOutcomeCacheStats(unsigned long long *hits, unsigned long long *misses) {
+			if (hits != nullptr) {
+				*hits = outcome_cache.hits.load();
+			}
+			if (misses != nullptr) {
+				*misses = outcome_cache.misses.load();
+			}
+		}
+
+		// Look up outcome of simulation
+		bool LookupOutcome(GameState* const game_state, const ShotVec &shot_vec, int *steps) {
+			if (outcome_cache.slots == nullptr) {
+				return false;
+			}
+
+			CacheKey key;
+			MakeKey(*game_state, shot_vec, &key);
+			uint64_t hash = HashBytes(&key, sizeof(key));
+
+			for (unsigned int i = 0; i < kMaxProbe; i++) {
+				CacheSlot &slot = outcome_cache.slots[(hash + i) % outcome_cache.num_slots];
+				uint32_t state = slot.state.load(std::memory_order_acquire);
+				if (state == kSlotEmpty) {
+					break;
+				}
+				if (state != kSlotReady || slot.hash != static_cast<uint32_t>(hash) ||
+					memcmp(&slot.key, &key, sizeof(key)) != 0) {
+					continue;
+				}
+
+				// Apply outcome to game_state
+				if (slot.foul) {
+					game_state->ShotNum++;
+					game_state->WhiteToMove ^= 1;
+				}
+				else {
+					game_state->ShotNum++;
+					for (unsigned int j = 0; j < game_state->ShotNum; j++) {
+						game_state->body[j][0] = slot.body[j][0];
+						game_state->body[j][1] = slot.body[j][1];
+					}
+					UpdateTurn(game_state);
+				}
+				*steps = slot.steps;
+				outcome_cache.hits++;
+				return true;
+			}
+
+			outcome_cache.misses++;
+			return false;
+		}
+
+		// Store outcome of simulation
+		void StoreOutcome(
+			const GameState &before, const ShotVec &shot_vec,
+			const GameState &after, int steps, bool foul) {
+			if (outcome_cache.slots == nullptr) {
+				return;
+			}
+
+			CacheKey key;
+			MakeKey(before, shot_vec, &key);
+			uint64_t hash = HashBytes(&key, sizeof(key));
+
+			for (unsigned int i = 0; i < kMaxProbe; i++) {
+				CacheSlot &slot = outcome_cache.slots[(hash + i) % outcome_cache.num_slots];
+				uint32_t state = slot.state.load(std::memory_order_acquire);
+				if (state == kSlotReady && slot.hash == static_cast<uint32_t>(hash) &&
+					memcmp(&slot.key, &key, sizeof(key)) == 0) {
+					// Already stored
+					return;
+				}
+				if (state != kSlotEmpty ||
+					!slot.state.compare_exchange_strong(state, kSlotWriting, std::memory_order_acquire)) {
+					// Used by other key (or other process is writing)
+					continue;
+				}
+
+				// Write outcome and publish slot
+				slot.hash = static_cast<uint32_t>(hash);
+				slot.key = key;
+				memset(slot.body, 0x00, sizeof(slot.body));
+				for (unsigned int j = 0; j < after.ShotNum && j < 16; j++) {
+					slot.body[j][0] = after.body[j][0];
+					slot.body[j][1] = after.body[j][1];
+				}
+				slot.steps = steps;
+				slot.foul = foul ? 1 : 0;
+				slot.state.store(kSlotReady, std::memory_order_release);
+				return;
+			}
+			// Give up storing if probe sequence is full
+		}
+	}
+}
@@ -0,0 +1,394 @@
+// Command-line batch driver
+//  Input file is memory-mapped and read in chunks of kBatchChunk jobs.
+//  Each chunk is run on all threads, then written in input order,
+//  so memory usage does not depend on num of jobs.
+#include "dcurling_simulator_driver.h"
+#include "dcurling_simulator_internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr size_t kBatchChunk = 4096;        // Num of jobs read at once
+		constexpr size_t kCsvMaxLine = 4096;        // Max length of a line in CSV
+		constexpr size_t kCsvNumFields = 4 + 32 + 6;  // Last field is seed
+
+		// Read-only memory-mapped file
+		class MappedFile {
+		public:
+			~MappedFile() {
+				Close();
+			}
+
+			bool Open(const char *path) {
+#ifdef _WIN32
+				file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+					OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				if (file_ == INVALID_HANDLE_VALUE) {
+					return false;
+				}
+				LARGE_INTEGER size;
+				if (!GetFileSizeEx(file_, &size)) {
+					return false;
+				}
+				size_ = static_cast<size_t>(size.QuadPart);
+				if (size_ == 0) {
+					return true;
+				}
+				mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping_ == nullptr) {
+					return false;
+				}
+				data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+				return data_ != nullptr;
+#else // _WIN32
+				int fd = open(path, O_RDONLY);
+				if (fd < 0) {
+					return false;
+				}
+				struct stat st;
+				if (fstat(fd, &st) != 0) {
+					close(fd);
+					return false;
+				}
+				size_ = static_cast<size_t>(st.st_size);
+				if (size_ == 0) {
+					close(fd);
+					return true;
+				}
+				void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				close(fd);
+				if (addr == MAP_FAILED) {
+					return false;
+				}
+				madvise(addr, size_, MADV_SEQUENTIAL);
+				data_ = static_cast<const char*>(addr);
+				return true;
+#endif // _WIN32
+			}
+
+			void Close() {
+#ifdef _WIN32
+				if (data_ != nullptr) {
+					UnmapViewOfFile(data_);
+				}
+				if (mapping_ != nullptr) {
+					CloseHandle(mapping_);
+				}
+				if (file_ != INVALID_HANDLE_VALUE) {
+					CloseHandle(file_);
+				}
+				mapping_ = nullptr;
+				file_ = INVALID_HANDLE_VALUE;
+#else // _WIN32
+				if (data_ != nullptr) {
+					munmap(const_cast<char*>(data_), size_);
+				}
+#endif // _WIN32
+				data_ = nullptr;
+				size_ = 0;
+			}
+
+			const char *data() const { return data_; }
+			size_t size() const { return size_; }
+
+		private:
+			const char *data_ = nullptr;
+			size_t size_ = 0;
+#ifdef _WIN32
+			HANDLE file_ = INVALID_HANDLE_VALUE;
+			HANDLE mapping_ = nullptr;
+#endif // _WIN32
+		};
+
+		// Set SimJob from fields of a job (same order as CSV)
+		//  returns false if ShotNum, CurEnd or LastEnd is out of range
+		bool SetJob(const float *body, const int32_t *info, const float *shot,
+			float random_x, float random_y, uint32_t seed, SimJob *job) {
+			job->game_state.ShotNum = info[0];
+			job->game_state.CurEnd = info[1];
+			job->game_state.LastEnd = info[2];
+			job->game_state.WhiteToMove = (info[3] != 0);
+			memcpy(job->game_state.body, body, sizeof(job->game_state.body));
+			job->shot_vec = ShotVec(shot[0], shot[1], shot[2] != 0.0f);
+			job->random_x = random_x;
+			job->random_y = random_y;
+			job->seed = seed;
+			return job->game_state.ShotNum <= 15 && IsValidState(job->game_state);
+		}
+
+		// Reader of job file
+		class JobReader {
+		public:
+			bool Open(const char *path) {
+				if (!file_.Open(path)) {
+					return false;
+				}
+				BatchFileHeader header;
+				if (file_.size() >= sizeof(header)) {
+					memcpy(&header, file_.data(), sizeof(header));
+					binary_ = (header.magic == kBatchJobMagic);
+				}
+				if (binary_) {
+					// Compare by division to avoid overflow of count
+					if (header.version != kBatchFileVersion ||
+						header.count > (file_.size() - sizeof(header)) / sizeof(BatchJobRecord)) {
+						return false;
+					}
+					count_ = header.count;
+					pos_ = sizeof(header);
+				}
+				else {
+					// Count lines for progress
+					const char *p = file_.data();
+					const char *end = p + file_.size();
+					while (p < end) {
+						const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+						if (IsJobLine(p, eol ? eol : end)) {
+							count_++;
+						}
+						p = eol ? eol + 1 : end;
+					}
+				}
+				return true;
+			}
+
+			// Num of jobs in file
+			uint64_t count() const { return count_; }
+
+			// Read up to max_count jobs (returns num of jobs read, -1 if format error)
+			long long Read(SimJob *jobs, size_t max_count, uint64_t first_id) {
+				size_t n = 0;
+				if (binary_) {
+					while (n < max_count && pos_ + sizeof(BatchJobRecord) <= file_.size() && read_ < count_) {
+						BatchJobRecord record;
+						memcpy(&record, file_.data() + pos_, sizeof(record));
+						pos_ += sizeof(record);
+						if (!SetJob(&record.body[0][0], record.info, record.shot,
+							record.random_x, record.random_y, record.seed, &jobs[n])) {
+							return -1;
+						}
+						jobs[n].id = first_id + n;
+						n++;
+						read_++;
+					}
+					return static_cast<long long>(n);
+				}
+
+				const char *end = file_.data() + file_.size();
+				while (n < max_count && pos_ < file_.size()) {
+					const char *p = file_.data() + pos_;
+					const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+					const char *line_end = eol ? eol : end;
+					pos_ = (eol ? eol + 1 : end) - file_.data();
+					line_++;
+					if (!IsJobLine(p, line_end)) {
+						continue;
+					}
+					if (!ParseLine(p, line_end, &jobs[n])) {
+						return -1;
+					}
+					jobs[n].id = first_id + n;
+					n++;
+				}
+				return static_cast<long long>(n);
+			}
+
+			// Where format error was found
+			//  (line number of CSV, or index of record from 0 in binary file)
+			bool binary() const { return binary_; }
+			uint64_t position() const { return binary_ ? read_ : line_; }
+
+		private:
+			static bool IsJobLine(const char *p, const char *end) {
+				while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+					p++;
+				}
+				return p < end && *p != '#' &&
+					!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'));
+			}
+
+			static bool ParseLine(const char *p, const char *end, SimJob *job) {
+				char line[kCsvMaxLine];
+				size_t length = end - p;
+				if (length >= kCsvMaxLine) {
+					return false;
+				}
+				memcpy(line, p, length);
+				line[length] = '\0';
+
+				// Seed is parsed as integer (float cannot hold all of 32 bit seeds)
+				float fields[kCsvNumFields - 1];
+				unsigned long seed = 0;
+				char *cur = line;
+				for (size_t i = 0; i < kCsvNumFields; i++) {
+					char *next;
+					if (i < kCsvNumFields - 1) {
+						fields[i] = strtof(cur, &next);
+					}
+					else {
+						seed = strtoul(cur, &next, 10);
+					}
+					if (next == cur) {
+						return false;
+					}
+					cur = next;
+					while (*cur == ' ' || *cur == '\t') {
+						cur++;
+					}
+					if (*cur == ',') {
+						cur++;
+					}
+				}
+				// Extra fields are not allowed (trailing comma is)
+				while (*cur == ' ' || *cur == '\t' || *cur == '\r') {
+					cur++;
+				}
+				if (*cur != '\0' || seed > 0xFFFFFFFFul) {
+					return false;
+				}
+
+				int32_t info[4];
+				for (int i = 0; i < 4; i++) {
+					if (!(fields[i] >= 0.0f && fields[i] < 2147483648.0f)) {
+						return false;
+					}
+					info[i] = static_cast<int32_t>(fields[i]);
+				}
+				return SetJob(&fields[4], info, &fields[36], fields[39], fields[40],
+					static_cast<uint32_t>(seed), job);
+			}
+
+			MappedFile file_;
+			bool binary_ = false;
+			uint64_t count_ = 0;
+			uint64_t read_ = 0;
+			uint64_t line_ = 0;
+			size_t pos_ = 0;
+		};
+
+		// Write results to output file
+		bool WriteResults(FILE *fp, bool binary, const SimResult *results, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				const SimResult &r = results[i];
+				const GameState &gs = r.game_state;
+				int score = (gs.CurEnd < kLastEndMax) ? gs.Score[gs.CurEnd] : 0;
+				if (binary) {
+					BatchResultRecord record;
+					memcpy(record.body, gs.body, sizeof(record.body));
+					record.info[0] = gs.ShotNum;
+					record.info[1] = gs.CurEnd;
+					record.info[2] = gs.LastEnd;
+					record.info[3] = gs.WhiteToMove ? 1 : 0;
+					record.info[4] = score;
+					record.shot[0] = r.run_shot.x;
+					record.shot[1] = r.run_shot.y;
+					record.shot[2] = r.run_shot.angle ? 1.0f : 0.0f;
+					record.steps = r.steps;
+					if (fwrite(&record, sizeof(record), 1, fp) != 1) {
+						return false;
+					}
+				}
+				else {
+					fprintf(fp, "%llu,%u,%u,%u,%d,%d", r.id, gs.ShotNum, gs.CurEnd, gs.LastEnd,
+						gs.WhiteToMove ? 1 : 0, score);
+					for (unsigned int j = 0; j < 16; j++) {
+						fprintf(fp, ",%.6f,%.6f", gs.body[j][0], gs.body[j][1]);
+					}
+					if (fprintf(fp, ",%.6f,%.6f,%d,%d\n", r.run_shot.x, r.run_shot.y,
+						r.run_shot.angle ? 1 : 0, r.steps) < 0) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Run jobs in input file and write results to output file
+		int RunBatchFile(const char *input, const char *output, unsigned int num_threads, bool progress) {
+			JobReader reader;
+			if (!reader.Open(input)) {
+				fprintf(stderr, "batch: cannot read %s\n", input);
+				return 1;
+			}
+
+			size_t output_length = strlen(output);
+			bool binary = output_length >= 4 && strcmp(output + output_length - 4, ".bin") == 0;
+			FILE *fp = fopen(output, binary ? "wb" : "w");
+			if (fp == nullptr) {
+				fprintf(stderr, "batch: cannot write %s\n", output);
+				return 1;
+			}
+			setvbuf(fp, nullptr, _IOFBF, 1 << 20);
+			// Header is rewritten with num of records written after jobs are done
+			BatchFileHeader header = { kBatchResultMagic, kBatchFileVersion, 0 };
+			if (binary) {
+				fwrite(&header, sizeof(header), 1, fp);
+			}
+
+			std::vector<SimJob> jobs(kBatchChunk);
+			std::vector<SimResult> results(kBatchChunk);
+			uint64_t done = 0;
+			auto start = std::chrono::steady_clock::now();
+			int ret = 0;
+			for (;;) {
+				long long n = reader.Read(jobs.data(), kBatchChunk, done);
+				if (n < 0) {
+					fprintf(stderr, "\nbatch: format error at %s %llu\n", reader.binary() ? "record" : "line",
+						static_cast<unsigned long long>(reader.position()));
+					ret = 1;
+					break;
+				}
+				if (n == 0) {
+					break;
+				}
+
+				RunJobs(jobs.data(), results.data(), static_cast<size_t>(n), num_threads);
+				if (!WriteResults(fp, binary, results.data(), static_cast<size_t>(n))) {
+					fprintf(stderr, "\nbatch: write error\n");
+					ret = 1;
+					break;
+				}
+				done += n;
+
+				if (progress) {
+					double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+					fprintf(stderr, "\rbatch: %llu / %llu jobs (%.0f jobs/s)",
+						static_cast<unsigned long long>(done),
+						static_cast<unsigned long long>(reader.count()),
+						(sec > 0.0) ? done / sec : 0.0);
+				}
+			}
+			if (progress) {
+				fprintf(stderr, "\n");
+			}
+
+			if (binary) {
+				header.count = done;
+				if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, fp) != 1) {
+					fprintf(stderr, "batch: write error\n");
+					ret = 1;
+				}
+			}
+			if (fclose(fp) != 0) {
+				ret = 1;
+			}
+			return ret;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Command-line batch driver
+//      DCSimulator batch <input> <output> [num_threads]
+//
+//  Input is a binary job file (BatchFileHeader, BatchJobRecord[count])
+//  or a CSV file with a job per line:
+//      ShotNum,CurEnd,LastEnd,WhiteToMove,x0,y0,...,x15,y15,shot_x,shot_y,angle,random_x,random_y,seed
+//  (lines starting with '#' or a letter are skipped)
+//  A job with ShotNum > 15, CurEnd >= kLastEndMax or LastEnd > kLastEndMax
+//  is a format error.
+//
+//  Output is written in input order as CSV:
+//      index,ShotNum,CurEnd,LastEnd,WhiteToMove,Score,x0,y0,...,x15,y15,run_x,run_y,angle,steps
+//  or as binary (BatchFileHeader, BatchResultRecord[count]) if output ends with ".bin"
+//  (count is num of results written, which is less than num of jobs if batch failed)
+
+#include "dcurling_simulator.h"
+
+#include <cstdint>
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr uint32_t kBatchJobMagic    = 0x4A534344;  // "DCSJ"
+		constexpr uint32_t kBatchResultMagic = 0x42534344;  // "DCSB"
+		constexpr uint32_t kBatchFileVersion = 1;
+
+		// Header of binary job / result file
+		struct BatchFileHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t count;    // Num of records
+		};
+
+		// Record of binary job file
+		struct BatchJobRecord {
+			float body[16][2];
+			int32_t info[4];   // ShotNum, CurEnd, LastEnd, WhiteToMove
+			float shot[3];     // x, y, angle (0: false, otherwise true)
+			float random_x;
+			float random_y;
+			uint32_t seed;     // 0: non-deterministic
+		};
+
+		// Record of binary result file
+		struct BatchResultRecord {
+			float body[16][2];
+			int32_t info[5];   // ShotNum, CurEnd, LastEnd, WhiteToMove, Score of CurEnd
+			float shot[3];     // Shot with random number
+			int32_t steps;
+		};
+
+		// Run jobs in input file and write results to output file
+		//  progress    : print progress to stderr
+		//  returns 0 if succeeded
+		DLLEXP int RunBatchFile(const char *input, const char *output, unsigned int num_threads, bool progress);
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+// Internal declarations shared by translation units of the simulator
+//  Note: Not a part of exported API
+
+#include "dcurling_simulator.h"
+
+#include <atomic>
+#include <functional>
+#include <random>
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		// Constant values for Stone
+		constexpr float kStoneDensity    = 10.0f;
+		constexpr float kStoneResitution = 1.0f;
+		constexpr float kStoneFriction   = 12.009216f;
+		constexpr float kStandardAngle   = 0.066696f;
+		//constexpr float kForceVerticalBase = kStandardAngle * kStoneFriction;
+
+		// Constant values for Rink
+		constexpr float kPlayAreaXLeft   = 0.000f + kStoneR;
+		constexpr float kPlayAreaXRight  = kSideX - kStoneR;
+		constexpr float kPlayAreaYTop    = 3.050f + kStoneR;
+		constexpr float kPlayAreaYBottom = kHogY - kStoneR;
+		constexpr float kRinkYTop        = 0.000f + kStoneR;
+		constexpr float kRinkYBottom     = 3.050f + kRinkHeight - kStoneR;
+		constexpr float kHackY           = 41.280f;     // Y coord of Hack?
+
+		// Constant values for simulation
+		constexpr int kVelocityIterations = 10;        // Iteration?
+		constexpr int kPositionIterations = 10;        // Iteration?
+		constexpr float kTimeStep = (1.0f / 1000.0f);  // Flame rate
+
+		// Revision of simulation code
+		//  Increment this when a change alters results of Simulation()
+		//  (invalidates outcome cache files created by older revision)
+		constexpr unsigned int kPhysicsRevision = 2;
+
+		// Options
+		extern unsigned int num_freeguard;
+		extern StoneArea area_freeguard;
+		extern std::atomic<bool> step_stats;
+
+		// Simulate shot_vec (random number is already added)
+		int SimulateShot(
+			GameState* const game_state,
+			const ShotVec &shot_vec,
+			float *trajectory, size_t traj_size);
+
+		// Statistics of the last simulation in this thread
+		extern thread_local SimStats last_stats;
+		// Clear statistics (and counters of Box2D in this thread)
+		void ResetStats();
+
+		// Add random number to ShotVec with given random engine
+		void AddRandom2Vec(float random_x, float random_y, ShotVec* const vec, std::default_random_engine &engine);
+
+		// Call func(i) for i in [0, count) on num_threads threads (0: num of cores)
+		void ParallelFor(size_t count, unsigned int num_threads, const std::function<void(size_t)> &func);
+
+		// Update game_state with positions of stones after simulation
+		//  body : positions of 16 stones ((0, 0) for removed stones)
+		//  returns false if shot was canceled by freeguard zone rule
+		//  (then only ShotNum and WhiteToMove are updated)
+		bool ApplyShot(GameState* const game_state, const float (*body)[2]);
+
+		// Update Score and WhiteToMove (ShotNum and positions are already updated)
+		void UpdateTurn(GameState* const game_state);
+
+		// Check ShotNum, CurEnd and LastEnd of GameState received from outside
+		//  (simulation accesses stones up to ShotNum and Score[CurEnd])
+		bool IsValidState(const GameState &game_state);
+
+		// Outcome cache (dcurling_simulator_cache.cpp)
+		//  returns true and sets game_state / steps if outcome is in cache
+		bool LookupOutcome(GameState* const game_state, const ShotVec &shot_vec, int *steps);
+		// Store outcome of simulation
+		//  before: GameState before simulation, after: GameState after simulation
+		//  foul  : true if shot was canceled by freeguard zone rule
+		void StoreOutcome(
+			const GameState &before, const ShotVec &shot_vec,
+			const GameState &after, int steps, bool foul);
+	}
+}
@@ -0,0 +1,151 @@
+// Lockstep simulation of boards in SIMD lanes
+//  Monte Carlo batches run shots from the same GameState. Stones of W boards
+//  (W = width of SIMD vector) are kept in [stone][lane] arrays and all boards
+//  are advanced by the same step. A lane takes next shot when its board stops.
+//
+//  Collisions are solved with a circle model of stones instead of Box2D:
+//  the same impulses as Box2D contact solver for a single point contact of two
+//  circles of same mass, without broad-phase, islands and warm starting.
+//  Steps without collision are bit-identical to Box2D, but results of
+//  collisions are close to (not same as) Simulation().
+//
+//  Lanes do not depend on each other, so results are the same for any width
+//  and the widest instruction set of CPU is selected at runtime.
+#include "dcurling_simulator.h"
+#include "dcurling_simulator_lockstep.h"
+
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <intrin.h>
+#elif defined(b2_useSSE2)
+#include <cpuid.h>
+#endif // _WIN32
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		namespace simd {
+
+#include "dcurling_simulator_lockstep.inl"
+
+			void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+				GameState *results, int *steps, std::atomic<size_t> &next, size_t count) {
+				LockstepBoards<Native> boards(game_state, run_shots, results, steps);
+				boards.Run(next, count);
+			}
+		}
+
+		// Detect instruction set of CPU (and OS support of its registers)
+		//  Capped at SIMD_AVX2 if AVX-512 engine is not built.
+		SimdPath DetectSimdPath() {
+#ifdef b2_useSSE2
+			bool sse42, avx2, avx512;
+#ifdef _WIN32
+			int info[4];
+			__cpuid(info, 0);
+			int max_leaf = info[0];
+			__cpuid(info, 1);
+			sse42 = (info[2] & (1 << 20)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			unsigned long long xcr0 = (info[2] & (1 << 27)) ? _xgetbv(0) : 0;  // OSXSAVE
+			avx2 = avx512 = false;
+			if (max_leaf >= 7) {
+				__cpuidex(info, 7, 0);
+				avx2 = avx && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;        // YMM
+				avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;           // ZMM, opmask
+			}
+#else // _WIN32
+			__builtin_cpu_init();
+			sse42 = __builtin_cpu_supports("sse4.2") != 0;
+			avx2 = __builtin_cpu_supports("avx2") != 0;
+			avx512 = __builtin_cpu_supports("avx512f") != 0;
+#endif // _WIN32
+#ifdef DCS_HAS_AVX512_LOCKSTEP
+			if (avx512) {
+				return SIMD_AVX512;
+			}
+#endif // DCS_HAS_AVX512_LOCKSTEP
+			if (avx2) {
+				return SIMD_AVX2;
+			}
+			if (sse42) {
+				return SIMD_SSE42;
+			}
+			return SIMD_SSE2;
+#else // b2_useSSE2
+			return SIMD_SCALAR;
+#endif // b2_useSSE2
+		}
+
+		// Get instruction set of vectorized kernels (detected once)
+		SimdPath GetSimdPath() {
+			static const SimdPath path = DetectSimdPath();
+			return path;
+		}
+
+		// Simulate shots from a GameState in lockstep
+		void SimulateLockstep(const GameState &game_state, const ShotVec *run_shots, size_t count,
+			GameState *results, int *steps, unsigned int num_threads) {
+			ResetStats();
+			if (game_state.ShotNum >= kLockstepStones) {
+				// No stone to deliver: results are the input with steps = -1
+				for (size_t i = 0; i < count; i++) {
+					results[i] = game_state;
+					if (steps != nullptr) {
+						steps[i] = -1;
+					}
+				}
+				return;
+			}
+
+			// Engine of instruction set
+			SimdPath path = GetSimdPath();
+			auto run_lockstep = &simd::RunLockstep;
+			int width = simd::Native::kWidth;
+			switch (path) {
+			case SIMD_SSE42:
+				run_lockstep = &simd::sse42::RunLockstep;
+				width = simd::sse42::kWidth;
+				break;
+			case SIMD_AVX2:
+				run_lockstep = &simd::avx2::RunLockstep;
+				width = simd::avx2::kWidth;
+				break;
+#ifdef DCS_HAS_AVX512_LOCKSTEP
+			case SIMD_AVX512:
+				run_lockstep = &simd::avx512::RunLockstep;
+				width = simd::avx512::kWidth;
+				break;
+#endif // DCS_HAS_AVX512_LOCKSTEP
+			default:
+				break;
+			}
+			last_stats.simd_path = path;
+
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			// A thread takes shots for all lanes
+			size_t num_boards = (count + width - 1) / width;
+			num_threads = static_cast<unsigned int>(std::min<size_t>(num_threads, std::max<size_t>(num_boards, 1)));
+
+			std::atomic<size_t> next(0);
+			auto run = [&]() {
+				run_lockstep(game_state, run_shots, results, steps, next, count);
+			};
+
+			// Calling thread also works
+			std::vector<std::thread> threads;
+			for (unsigned int i = 1; i < num_threads; i++) {
+				threads.emplace_back(run);
+			}
+			run();
+			for (auto &t : threads) {
+				t.join();
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Internal declarations of lockstep simulation (dcurling_simulator_lockstep*.cpp)
+//  The engine is built for vector types of the build and, in a file for each
+//  instruction set, for SSE4.2, AVX2 and AVX-512. GetSimdPath() selects one by CPU.
+//  Note: Not a part of exported API
+
+#include "dcurling_simulator_internal.h"
+#include "dcurling_simulator_simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+// AVX-512 engine needs __m512, which Visual C++ has since Visual Studio 2017 15.3
+#if defined(b2_useSSE2) && (!defined(_MSC_VER) || _MSC_VER >= 1911)
+#define DCS_HAS_AVX512_LOCKSTEP
+#endif
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr unsigned int kLockstepStones = 16;
+		constexpr unsigned int kLockstepContacts = kLockstepStones * (kLockstepStones - 1) / 2;
+
+		namespace simd {
+
+			// Run shots in lockstep until next reaches count (shots are taken one by one from next)
+			//  simd::RunLockstep uses vector types of the build, others are only called
+			//  if CPU supports their instruction set.
+			void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+				GameState *results, int *steps, std::atomic<size_t> &next, size_t count);
+
+			namespace sse42 {
+				constexpr int kWidth = 4;
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count);
+			}
+			namespace avx2 {
+				constexpr int kWidth = 8;
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count);
+			}
+#ifdef DCS_HAS_AVX512_LOCKSTEP
+			namespace avx512 {
+				constexpr int kWidth = 16;
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count);
+			}
+#endif // DCS_HAS_AVX512_LOCKSTEP
+		}
+	}
+}
@@ -0,0 +1,452 @@
+// Lockstep engine (template on vector type V)
+//  No include guard: included in a namespace with Friction() of the same
+//  instruction set (dcurling_simulator_lockstep*.cpp).
+//  Note: Not a part of exported API
+
+			// Boards in lanes of vector type V
+			template <class V>
+			class LockstepBoards {
+			public:
+				typedef typename V::Type Vec;
+				static constexpr int kWidth = V::kWidth;
+
+				LockstepBoards(const GameState &game_state, const ShotVec *run_shots, GameState *results, int *steps)
+					: game_state_(game_state), run_shots_(run_shots), results_(results), steps_(steps) {
+					shot_num_ = game_state.ShotNum;
+					friction_ = V::Set(kStoneFriction * kTimeStep);
+					half_friction_ = V::Set(kStoneFriction * kTimeStep * 0.5f);
+					contact_friction_ = std::sqrt(kStoneFriction * kStoneFriction);  // b2MixFriction
+				}
+
+				// Run shots until next reaches count (shots are taken one by one from next)
+				void Run(std::atomic<size_t> &next, size_t count) {
+					next_ = &next;
+					count_ = count;
+					present_ = 0;
+					moving_ = 0;
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						for (int lane = 0; lane < kWidth; lane++) {
+							x_[i][lane] = y_[i][lane] = 0.0f;
+							vx_[i][lane] = vy_[i][lane] = w_[i][lane] = 0.0f;
+							in_play_[i][lane] = moving_lanes_[i][lane] = 0.0f;
+						}
+					}
+
+					int fresh = 0;
+					for (int lane = 0; lane < kWidth; lane++) {
+						if (Load(lane)) {
+							fresh |= 1 << lane;
+						}
+					}
+					active_ = fresh;
+
+					while (active_ != 0) {
+						AddFriction(shot_num_, V::FromMask(fresh), half_friction_);
+						Step();
+
+						// Finish stopped boards and load next shots
+						fresh = 0;
+						for (int lane = 0; lane < kWidth; lane++) {
+							if ((active_ & (1 << lane)) && !(lane_moving_ & (1 << lane))) {
+								Finish(lane);
+								if (Load(lane)) {
+									fresh |= 1 << lane;
+								}
+								else {
+									active_ &= ~(1 << lane);
+								}
+							}
+						}
+					}
+				}
+
+			private:
+				// Contact of two stones in lanes
+				struct Contact {
+					unsigned int a, b;
+					Vec touch;           // Lanes where stones touch
+					Vec nx, ny;          // Normal from a to b
+					Vec rx, ry;          // Contact point from a (from b is -r)
+					Vec normal_mass;     // Masses are per unit mass of stone
+					Vec tangent_mass;
+					Vec bias;            // Velocity bias for restitution
+					Vec normal_impulse;
+					Vec tangent_impulse;
+				};
+
+				// Load next shot to lane
+				//  returns false if no shot is left
+				bool Load(int lane) {
+					size_t job = next_->fetch_add(1);
+					if (job >= count_) {
+						return false;
+					}
+					lane_job_[lane] = job;
+					lane_steps_[lane] = -1;
+					const ShotVec &shot = run_shots_[job];
+
+					// Stones in GameState (removed stones are not in play, same as Board)
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						bool in_play = i < shot_num_ && (
+							(kPlayAreaXLeft < game_state_.body[i][0] && game_state_.body[i][0] < kPlayAreaXRight) &&
+							(kRinkYTop < game_state_.body[i][1] && game_state_.body[i][1] < kRinkYBottom));
+						SetLane(i, lane, game_state_.body[i][0], game_state_.body[i][1], 0.0f, 0.0f, 0.0f, in_play);
+					}
+
+					// Delivered stone
+					SetLane(shot_num_, lane, kCenterX, kHackY, shot.x, shot.y,
+						shot.angle ? -1 * kStandardAngle : kStandardAngle, true);
+					moving_lanes_[shot_num_][lane] = AllBits();
+					present_ |= 1u << shot_num_;
+					moving_ |= 1u << shot_num_;
+
+					return true;
+				}
+
+				void SetLane(unsigned int i, int lane, float x, float y, float vx, float vy, float w, bool in_play) {
+					x_[i][lane] = x;
+					y_[i][lane] = y;
+					vx_[i][lane] = vx;
+					vy_[i][lane] = vy;
+					w_[i][lane] = w;
+					in_play_[i][lane] = in_play ? AllBits() : 0.0f;
+					moving_lanes_[i][lane] = 0.0f;
+					if (in_play) {
+						present_ |= 1u << i;
+					}
+				}
+
+				// Lane mask of a lane
+				static float AllBits() {
+					float bits;
+					const uint32_t all = 0xFFFFFFFFu;
+					memcpy(&bits, &all, sizeof(bits));
+					return bits;
+				}
+				static bool IsSet(float mask) {
+					uint32_t bits;
+					memcpy(&bits, &mask, sizeof(bits));
+					return bits != 0;
+				}
+
+				// Write result of board in lane
+				void Finish(int lane) {
+					size_t job = lane_job_[lane];
+
+					// Remove delivered stone if not in playarea
+					float x = x_[shot_num_][lane];
+					float y = y_[shot_num_][lane];
+					if (!((kPlayAreaXLeft < x && x < kPlayAreaXRight) && (kPlayAreaYTop < y && y < kPlayAreaYBottom))) {
+						in_play_[shot_num_][lane] = 0.0f;
+					}
+
+					float body[kLockstepStones][2];
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						bool in_play = IsSet(in_play_[i][lane]);
+						body[i][0] = in_play ? x_[i][lane] : 0.0f;
+						body[i][1] = in_play ? y_[i][lane] : 0.0f;
+						in_play_[i][lane] = moving_lanes_[i][lane] = 0.0f;
+						vx_[i][lane] = vy_[i][lane] = w_[i][lane] = 0.0f;
+					}
+
+					results_[job] = game_state_;
+					bool foul = !ApplyShot(&results_[job], body);
+					if (steps_ != nullptr) {
+						steps_[job] = foul ? 0 : lane_steps_[lane];
+					}
+				}
+
+				// Add friction to stone i in lanes
+				void AddFriction(unsigned int i, Vec lanes, Vec friction) {
+					lanes = V::And(lanes, V::Load(&in_play_[i][0]));
+					if (V::Mask(lanes) == 0) {
+						return;
+					}
+					Vec vx = V::Load(&vx_[i][0]);
+					Vec vy = V::Load(&vy_[i][0]);
+					Vec w = V::Load(&w_[i][0]);
+					Vec fx = vx;
+					Vec fy = vy;
+					Friction<V>(friction, w, fx, fy);
+
+					// Stopped stones have no angular velocity
+					Vec stop = V::And(lanes, V::CmpEq(V::Add(V::Mul(fx, fx), V::Mul(fy, fy)), V::Zero()));
+					V::Store(&vx_[i][0], V::Select(lanes, fx, vx));
+					V::Store(&vy_[i][0], V::Select(lanes, fy, vy));
+					V::Store(&w_[i][0], V::AndNot(stop, w));
+				}
+
+				// Advance all boards by a step
+				void Step() {
+					const Vec zero = V::Zero();
+					const Vec h = V::Set(kTimeStep);
+					const Vec inv_inertia = V::Set(2.0f / (kStoneR * kStoneR));  // mass / inertia of stone
+					const float radius = kStoneR + kStoneR;
+
+					for (int lane = 0; lane < kWidth; lane++) {
+						lane_steps_[lane]++;
+					}
+
+					// Find touching stones
+					//  Islands of Box2D are built from awake (moving) stones through touching
+					//  contacts, so stones touching awake stones are woken in each lane.
+					unsigned int awake = moving_;  // Bit i is set if stone i is awake in some lane
+					unsigned int scanned = 0;
+					unsigned int pairs[kLockstepStones] = {};  // Bit b of pairs[a] (a < b): touch in some lane
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						awake_lanes_[i] = V::Load(&moving_lanes_[i][0]);
+					}
+					while (awake & ~scanned) {
+						// Test pairs of newly awake stones
+						unsigned int scan = awake & ~scanned;
+						for (unsigned int a = 0; a < kLockstepStones; a++) {
+							if (!(present_ & (1u << a))) {
+								continue;
+							}
+							for (unsigned int b = a + 1; b < kLockstepStones; b++) {
+								if (!(present_ & (1u << b)) ||
+									!((scan >> a | scan >> b) & 1) || ((scanned >> a | scanned >> b) & 1)) {
+									continue;
+								}
+								Vec dx = V::Sub(V::Load(&x_[b][0]), V::Load(&x_[a][0]));
+								Vec dy = V::Sub(V::Load(&y_[b][0]), V::Load(&y_[a][0]));
+								Vec d2 = V::Add(V::Mul(dx, dx), V::Mul(dy, dy));
+								Vec touch = V::And(V::CmpLe(d2, V::Set(radius * radius)),
+									V::And(V::Load(&in_play_[a][0]), V::Load(&in_play_[b][0])));
+								if (V::Mask(touch) != 0) {
+									touch_[a][b] = touch;
+									pairs[a] |= 1u << b;
+								}
+							}
+						}
+						scanned |= scan;
+
+						// Wake stones touching awake stones
+						for (bool changed = true; changed; ) {
+							changed = false;
+							for (unsigned int a = 0; a < kLockstepStones; a++) {
+								for (unsigned int bits = pairs[a]; bits != 0; bits &= bits - 1) {
+									unsigned int b = LowestBit(bits);
+									Vec wake = V::And(touch_[a][b], V::Or(awake_lanes_[a], awake_lanes_[b]));
+									if (V::Mask(V::AndNot(awake_lanes_[a], wake)) | V::Mask(V::AndNot(awake_lanes_[b], wake))) {
+										awake_lanes_[a] = V::Or(awake_lanes_[a], wake);
+										awake_lanes_[b] = V::Or(awake_lanes_[b], wake);
+										awake |= (1u << a) | (1u << b);
+										changed = true;
+									}
+								}
+							}
+						}
+					}
+
+					// Contacts of awake stones (in order of stones)
+					num_contacts_ = 0;
+					for (unsigned int a = 0; a < kLockstepStones; a++) {
+						for (unsigned int bits = pairs[a]; bits != 0; bits &= bits - 1) {
+							unsigned int b = LowestBit(bits);
+							Vec touch = V::And(touch_[a][b], V::Or(awake_lanes_[a], awake_lanes_[b]));
+							if (V::Mask(touch) == 0) {
+								continue;
+							}
+							Vec dx = V::Sub(V::Load(&x_[b][0]), V::Load(&x_[a][0]));
+							Vec dy = V::Sub(V::Load(&y_[b][0]), V::Load(&y_[a][0]));
+							Vec d2 = V::Add(V::Mul(dx, dx), V::Mul(dy, dy));
+
+							// Normal and contact point (as b2WorldManifold for circles)
+							Contact &c = contacts_[num_contacts_++];
+							c.a = a;
+							c.b = b;
+							c.touch = touch;
+							Vec length = V::Sqrt(d2);
+							Vec normalize = V::CmpNlt(length, V::Set(b2_epsilon));
+							Vec valid = V::CmpGt(d2, V::Set(b2_epsilon * b2_epsilon));
+							Vec inv = V::Div(V::Set(1.0f), length);
+							c.nx = V::Select(valid, V::Select(normalize, V::Mul(dx, inv), dx), V::Set(1.0f));
+							c.ny = V::Select(valid, V::Select(normalize, V::Mul(dy, inv), dy), zero);
+							c.rx = V::Mul(V::Set(0.5f), dx);
+							c.ry = V::Mul(V::Set(0.5f), dy);
+
+							// Effective masses (rA = -rB)
+							Vec rn = V::Sub(V::Mul(c.rx, c.ny), V::Mul(c.ry, c.nx));
+							Vec rt = V::Sub(V::Mul(c.rx, V::Xor(c.nx, V::Set(-0.0f))), V::Mul(c.ry, c.ny));
+							c.normal_mass = V::Div(V::Set(1.0f),
+								V::Add(V::Set(2.0f), V::Mul(V::Add(inv_inertia, inv_inertia), V::Mul(rn, rn))));
+							c.tangent_mass = V::Div(V::Set(1.0f),
+								V::Add(V::Set(2.0f), V::Mul(V::Add(inv_inertia, inv_inertia), V::Mul(rt, rt))));
+
+							// Restitution above velocity threshold
+							Vec vn = RelativeVelocity(c, c.nx, c.ny);
+							c.bias = V::And(V::CmpLt(vn, V::Set(-b2_velocityThreshold)), V::Xor(vn, V::Set(-0.0f)));
+							c.normal_impulse = zero;
+							c.tangent_impulse = zero;
+						}
+					}
+
+					// Solve velocity constraints (tangent first, then normal as Box2D)
+					for (int iteration = 0; iteration < kVelocityIterations && num_contacts_ > 0; iteration++) {
+						for (unsigned int k = 0; k < num_contacts_; k++) {
+							Contact &c = contacts_[k];
+							Vec tx = c.ny;
+							Vec ty = V::Xor(c.nx, V::Set(-0.0f));
+
+							// Tangent impulse limited by friction
+							Vec vt = RelativeVelocity(c, tx, ty);
+							Vec max_friction = V::Mul(V::Set(contact_friction_), c.normal_impulse);
+							Vec impulse = V::Max(V::Min(
+								V::Sub(c.tangent_impulse, V::Mul(c.tangent_mass, vt)), max_friction),
+								V::Xor(max_friction, V::Set(-0.0f)));
+							Vec lambda = V::And(c.touch, V::Sub(impulse, c.tangent_impulse));
+							c.tangent_impulse = V::Select(c.touch, impulse, c.tangent_impulse);
+							ApplyImpulse(c, V::Mul(lambda, tx), V::Mul(lambda, ty), inv_inertia);
+
+							// Normal impulse
+							Vec vn = RelativeVelocity(c, c.nx, c.ny);
+							impulse = V::Max(V::Sub(c.normal_impulse, V::Mul(c.normal_mass, V::Sub(vn, c.bias))), zero);
+							lambda = V::And(c.touch, V::Sub(impulse, c.normal_impulse));
+							c.normal_impulse = V::Select(c.touch, impulse, c.normal_impulse);
+							ApplyImpulse(c, V::Mul(lambda, c.nx), V::Mul(lambda, c.ny), inv_inertia);
+						}
+					}
+
+					// Integrate positions of awake stones
+					unsigned int integrate = awake;
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						if (integrate & (1u << i)) {
+							V::Store(&x_[i][0], V::Add(V::Load(&x_[i][0]), V::Mul(h, V::Load(&vx_[i][0]))));
+							V::Store(&y_[i][0], V::Add(V::Load(&y_[i][0]), V::Mul(h, V::Load(&vy_[i][0]))));
+						}
+					}
+
+					// Solve position constraints
+					//  Lanes where all contacts are solved are not corrected any more.
+					Vec solving = V::CmpEq(zero, zero);
+					for (int iteration = 0; iteration < kPositionIterations && num_contacts_ > 0; iteration++) {
+						Vec min_separation = zero;
+						for (unsigned int k = 0; k < num_contacts_; k++) {
+							const Contact &c = contacts_[k];
+							Vec dx = V::Sub(V::Load(&x_[c.b][0]), V::Load(&x_[c.a][0]));
+							Vec dy = V::Sub(V::Load(&y_[c.b][0]), V::Load(&y_[c.a][0]));
+							Vec length = V::Sqrt(V::Add(V::Mul(dx, dx), V::Mul(dy, dy)));
+							Vec inv = V::Div(V::Set(1.0f), length);
+							Vec normalize = V::CmpNlt(length, V::Set(b2_epsilon));
+							Vec nx = V::Select(normalize, V::Mul(dx, inv), dx);
+							Vec ny = V::Select(normalize, V::Mul(dy, inv), dy);
+							Vec separation = V::Sub(V::Add(V::Mul(dx, nx), V::Mul(dy, ny)), V::Set(radius));
+							min_separation = V::Min(min_separation, V::Select(c.touch, separation, zero));
+
+							Vec correction = V::Max(V::Min(
+								V::Mul(V::Set(b2_baumgarte), V::Add(separation, V::Set(b2_linearSlop))), zero),
+								V::Set(-b2_maxLinearCorrection));
+							Vec impulse = V::And(V::And(c.touch, solving), V::Mul(V::Set(-0.5f), correction));
+							Vec px = V::Mul(impulse, nx);
+							Vec py = V::Mul(impulse, ny);
+							V::Store(&x_[c.a][0], V::Sub(V::Load(&x_[c.a][0]), px));
+							V::Store(&y_[c.a][0], V::Sub(V::Load(&y_[c.a][0]), py));
+							V::Store(&x_[c.b][0], V::Add(V::Load(&x_[c.b][0]), px));
+							V::Store(&y_[c.b][0], V::Add(V::Load(&y_[c.b][0]), py));
+						}
+						solving = V::And(solving, V::CmpLt(min_separation, V::Set(-3.0f * b2_linearSlop)));
+						if (V::Mask(solving) == 0) {
+							break;
+						}
+					}
+
+					// Add friction and find moving stones
+					unsigned int moving = 0;
+					Vec lane_moving = zero;
+					for (unsigned int i = 0; i < kLockstepStones; i++) {
+						if (!(integrate & (1u << i))) {
+							V::Store(&moving_lanes_[i][0], zero);
+							continue;
+						}
+						Vec in_play = V::Load(&in_play_[i][0]);
+						Vec stepped = V::And(awake_lanes_[i], in_play);
+						AddFriction(i, in_play, friction_);
+						Vec x = V::Load(&x_[i][0]);
+						Vec y = V::Load(&y_[i][0]);
+						Vec vx = V::Load(&vx_[i][0]);
+						Vec vy = V::Load(&vy_[i][0]);
+						Vec stone_moving = V::AndNot(
+							V::CmpEq(V::Add(V::Mul(vx, vx), V::Mul(vy, vy)), zero), in_play);
+
+						// Remove stones awake in the step which are out from Rink
+						//  (including stones stopped by friction of the step)
+						Vec in_rink = V::And(
+							V::And(V::CmpLt(V::Set(kPlayAreaXLeft), x), V::CmpLt(x, V::Set(kPlayAreaXRight))),
+							V::And(V::CmpLt(V::Set(kRinkYTop), y), V::CmpLt(y, V::Set(kRinkYBottom))));
+						Vec out = V::AndNot(in_rink, stepped);
+						if (V::Mask(out) != 0) {
+							V::Store(&in_play_[i][0], V::AndNot(out, in_play));
+							V::Store(&vx_[i][0], V::AndNot(out, vx));
+							V::Store(&vy_[i][0], V::AndNot(out, vy));
+							V::Store(&w_[i][0], V::AndNot(out, V::Load(&w_[i][0])));
+							stone_moving = V::AndNot(out, stone_moving);
+							if (V::Mask(V::Load(&in_play_[i][0])) == 0) {
+								present_ &= ~(1u << i);
+							}
+						}
+
+						V::Store(&moving_lanes_[i][0], stone_moving);
+						if (V::Mask(stone_moving) != 0) {
+							moving |= 1u << i;
+							lane_moving = V::Or(lane_moving, stone_moving);
+						}
+					}
+					moving_ = moving;
+					lane_moving_ = V::Mask(lane_moving);
+				}
+
+				// Normal component of relative velocity at contact point (b - a)
+				Vec RelativeVelocity(const Contact &c, Vec nx, Vec ny) const {
+					// v + cross(w, r), rB = -rA
+					Vec wa = V::Load(&w_[c.a][0]);
+					Vec wb = V::Load(&w_[c.b][0]);
+					Vec ws = V::Add(wa, wb);
+					Vec dvx = V::Add(V::Sub(V::Load(&vx_[c.b][0]), V::Load(&vx_[c.a][0])), V::Mul(ws, c.ry));
+					Vec dvy = V::Sub(V::Sub(V::Load(&vy_[c.b][0]), V::Load(&vy_[c.a][0])), V::Mul(ws, c.rx));
+					return V::Add(V::Mul(dvx, nx), V::Mul(dvy, ny));
+				}
+
+				// Apply impulse (per unit mass) to a (negative) and b (positive)
+				void ApplyImpulse(const Contact &c, Vec px, Vec py, Vec inv_inertia) {
+					// cross(rA, P) = cross(rB, -P)
+					Vec angular = V::Mul(inv_inertia, V::Sub(V::Mul(c.rx, py), V::Mul(c.ry, px)));
+					V::Store(&vx_[c.a][0], V::Sub(V::Load(&vx_[c.a][0]), px));
+					V::Store(&vy_[c.a][0], V::Sub(V::Load(&vy_[c.a][0]), py));
+					V::Store(&w_[c.a][0], V::Sub(V::Load(&w_[c.a][0]), angular));
+					V::Store(&vx_[c.b][0], V::Add(V::Load(&vx_[c.b][0]), px));
+					V::Store(&vy_[c.b][0], V::Add(V::Load(&vy_[c.b][0]), py));
+					V::Store(&w_[c.b][0], V::Sub(V::Load(&w_[c.b][0]), angular));
+				}
+
+				// Stones in [stone][lane]
+				alignas(64) float x_[kLockstepStones][kWidth];
+				alignas(64) float y_[kLockstepStones][kWidth];
+				alignas(64) float vx_[kLockstepStones][kWidth];
+				alignas(64) float vy_[kLockstepStones][kWidth];
+				alignas(64) float w_[kLockstepStones][kWidth];
+				alignas(64) float in_play_[kLockstepStones][kWidth];       // Lane masks
+				alignas(64) float moving_lanes_[kLockstepStones][kWidth];
+				Vec awake_lanes_[kLockstepStones];
+				Vec touch_[kLockstepStones][kLockstepStones];
+				Contact contacts_[kLockstepContacts];
+				unsigned int num_contacts_;
+
+				unsigned int present_;    // Bit i is set if stone i is in play in some lane
+				unsigned int moving_;     // Bit i is set if stone i is moving in some lane
+				int active_;              // Bit of lanes which have a shot
+				int lane_moving_;         // Bit of lanes which have a moving stone
+				size_t lane_job_[kWidth];
+				int lane_steps_[kWidth];
+
+				const GameState &game_state_;
+				const ShotVec *run_shots_;
+				GameState *results_;
+				int *steps_;
+				unsigned int shot_num_;
+				std::atomic<size_t> *next_;
+				size_t count_;
+				Vec friction_;
+				Vec half_friction_;
+				float contact_friction_;
+			};
@@ -0,0 +1,86 @@
+// Lockstep engine for AVX2 (selected at runtime by GetSimdPath())
+//  Code in the target region is compiled for AVX2. Headers are included
+//  before it, so inline functions shared with other files stay baseline.
+//  FMA is not used, so results are bit-identical to other instruction sets.
+#include "dcurling_simulator_lockstep.h"
+
+#ifdef b2_useSSE2
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif // __clang__
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		namespace simd {
+
+			namespace avx2 {
+
+				// 8 lanes of AVX2
+				struct Avx2 {
+					typedef __m256 Type;
+					static constexpr int kWidth = 8;
+
+					static Type Zero() { return _mm256_setzero_ps(); }
+					static Type Set(float a) { return _mm256_set1_ps(a); }
+					static Type Load(const float *p) { return _mm256_load_ps(p); }
+					static void Store(float *p, Type a) { _mm256_store_ps(p, a); }
+
+					static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+					static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+					static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+					static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+					static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+					static Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+					static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+
+					static Type And(Type a, Type b) { return _mm256_and_ps(a, b); }
+					static Type AndNot(Type a, Type b) { return _mm256_andnot_ps(a, b); }  // ~a & b
+					static Type Or(Type a, Type b) { return _mm256_or_ps(a, b); }
+					static Type Xor(Type a, Type b) { return _mm256_xor_ps(a, b); }
+					static Type Select(Type mask, Type a, Type b) { return _mm256_blendv_ps(b, a, mask); }
+
+					// Same predicates as SSE2 (ordered except for Neq and Nlt)
+					static Type CmpLt(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OS); }
+					static Type CmpLe(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LE_OS); }
+					static Type CmpGt(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OS); }
+					static Type CmpEq(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+					static Type CmpNeq(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+					static Type CmpNlt(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_NLT_US); }
+
+					// Bits of lanes in mask (bit i: lane i)
+					static int Mask(Type mask) { return _mm256_movemask_ps(mask); }
+					// Lane mask from bits
+					static Type FromMask(int bits) {
+						const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+						return _mm256_castsi256_ps(
+							_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), lanes), lanes));
+					}
+				};
+				static_assert(Avx2::kWidth == kWidth, "width of AVX2");
+
+#include "dcurling_simulator_simd_kernels.inl"
+#include "dcurling_simulator_lockstep.inl"
+
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count) {
+					LockstepBoards<Avx2> boards(game_state, run_shots, results, steps);
+					boards.Run(next, count);
+				}
+			}
+		}
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif // __clang__
+#endif // b2_useSSE2
@@ -0,0 +1,101 @@
+// Lockstep engine for AVX-512 (selected at runtime by GetSimdPath())
+//  Code in the target region is compiled for AVX-512F. Headers are included
+//  before it, so inline functions shared with other files stay baseline.
+//  GCC enables FMA with AVX-512F, so contraction is disabled to keep results
+//  bit-identical to other instruction sets.
+#include "dcurling_simulator_lockstep.h"
+
+#ifdef DCS_HAS_AVX512_LOCKSTEP
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+#endif // __clang__
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		namespace simd {
+
+			namespace avx512 {
+
+				// 16 lanes of AVX-512F (lane masks are kept in vectors as other types)
+				struct Avx512 {
+					typedef __m512 Type;
+					static constexpr int kWidth = 16;
+
+					static Type Zero() { return _mm512_setzero_ps(); }
+					static Type Set(float a) { return _mm512_set1_ps(a); }
+					static Type Load(const float *p) { return _mm512_load_ps(p); }
+					static void Store(float *p, Type a) { _mm512_store_ps(p, a); }
+
+					static Type Add(Type a, Type b) { return _mm512_add_ps(a, b); }
+					static Type Sub(Type a, Type b) { return _mm512_sub_ps(a, b); }
+					static Type Mul(Type a, Type b) { return _mm512_mul_ps(a, b); }
+					static Type Div(Type a, Type b) { return _mm512_div_ps(a, b); }
+					static Type Sqrt(Type a) { return _mm512_sqrt_ps(a); }
+					static Type Min(Type a, Type b) { return _mm512_min_ps(a, b); }
+					static Type Max(Type a, Type b) { return _mm512_max_ps(a, b); }
+
+					// Bitwise operations of AVX-512F are on integers
+					static Type And(Type a, Type b) {
+						return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+					}
+					static Type AndNot(Type a, Type b) {  // ~a & b
+						return _mm512_castsi512_ps(_mm512_andnot_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+					}
+					static Type Or(Type a, Type b) {
+						return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+					}
+					static Type Xor(Type a, Type b) {
+						return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+					}
+					static Type Select(Type mask, Type a, Type b) { return _mm512_mask_blend_ps(ToMask(mask), b, a); }
+
+					// Same predicates as SSE2 (ordered except for Neq and Nlt)
+					static Type CmpLt(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_LT_OS)); }
+					static Type CmpLe(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_LE_OS)); }
+					static Type CmpGt(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_GT_OS)); }
+					static Type CmpEq(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)); }
+					static Type CmpNeq(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ)); }
+					static Type CmpNlt(Type a, Type b) { return FromMask(_mm512_cmp_ps_mask(a, b, _CMP_NLT_US)); }
+
+					// Bits of lanes in mask (bit i: lane i)
+					static int Mask(Type mask) { return ToMask(mask); }
+					// Lane mask from bits
+					static Type FromMask(int bits) {
+						return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(static_cast<__mmask16>(bits), -1));
+					}
+
+				private:
+					static __mmask16 ToMask(Type mask) {
+						__m512i bits = _mm512_castps_si512(mask);
+						return _mm512_test_epi32_mask(bits, bits);
+					}
+				};
+				static_assert(Avx512::kWidth == kWidth, "width of AVX-512");
+
+#include "dcurling_simulator_simd_kernels.inl"
+#include "dcurling_simulator_lockstep.inl"
+
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count) {
+					LockstepBoards<Avx512> boards(game_state, run_shots, results, steps);
+					boards.Run(next, count);
+				}
+			}
+		}
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif // __clang__
+#endif // DCS_HAS_AVX512_LOCKSTEP
@@ -0,0 +1,48 @@
+// Lockstep engine for SSE4.2 (selected at runtime by GetSimdPath())
+//  Code in the target region is compiled for SSE4.2. Headers are included
+//  before it, so inline functions shared with other files stay baseline.
+#include "dcurling_simulator_lockstep.h"
+
+#ifdef b2_useSSE2
+#include <nmmintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif // __clang__
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		namespace simd {
+
+			namespace sse42 {
+
+				// 4 lanes of SSE4.2 (SSE2 with blend)
+				struct Sse42 : Sse2 {
+					static Type Select(Type mask, Type a, Type b) { return _mm_blendv_ps(b, a, mask); }
+				};
+				static_assert(Sse42::kWidth == kWidth, "width of SSE4.2");
+
+#include "dcurling_simulator_simd_kernels.inl"
+#include "dcurling_simulator_lockstep.inl"
+
+				void RunLockstep(const GameState &game_state, const ShotVec *run_shots,
+					GameState *results, int *steps, std::atomic<size_t> &next, size_t count) {
+					LockstepBoards<Sse42> boards(game_state, run_shots, results, steps);
+					boards.Run(next, count);
+				}
+			}
+		}
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif // __clang__
+#endif // b2_useSSE2
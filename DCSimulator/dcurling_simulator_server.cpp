@@ -0,0 +1,570 @@
+// Local simulation server
+//  A reader thread per connection pushes jobs to a pending queue.
+//  Worker threads take up to max_batch jobs at once (jobs of concurrent
+//  requests are coalesced, and shared by all workers), run them and queue
+//  results to each connection. A writer thread per connection sends queued
+//  results, so that workers never block on a socket.
+#include "dcurling_simulator_server.h"
+#include "dcurling_simulator_internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+// afunix.h is in Windows 10 SDK 10.0.17134 or later
+#ifdef NTDDI_WIN10_RS4
+#define DCS_HAS_AF_UNIX
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#endif // NTDDI_WIN10_RS4
+#else // _WIN32
+#define DCS_HAS_AF_UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+#ifdef DCS_HAS_AF_UNIX
+#ifdef _WIN32
+		typedef SOCKET Socket;
+		constexpr Socket kInvalidSocket = INVALID_SOCKET;
+		inline void CloseSocket(Socket s) { closesocket(s); }
+		inline void ShutdownSocket(Socket s) { shutdown(s, SD_BOTH); }
+		inline bool InitSocket() {
+			WSADATA wsa_data;
+			return WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+		}
+#else // _WIN32
+		typedef int Socket;
+		constexpr Socket kInvalidSocket = -1;
+		inline void CloseSocket(Socket s) { close(s); }
+		inline void ShutdownSocket(Socket s) { shutdown(s, SHUT_RDWR); }
+		inline bool InitSocket() { return true; }
+#endif // _WIN32
+
+		// Send / receive whole buffer (returns false if connection is closed)
+		bool SendAll(Socket s, const void *data, size_t size) {
+			const char *p = static_cast<const char*>(data);
+			while (size > 0) {
+#ifdef MSG_NOSIGNAL
+				auto sent = send(s, p, static_cast<int>(size), MSG_NOSIGNAL);
+#else // MSG_NOSIGNAL
+				auto sent = send(s, p, static_cast<int>(size), 0);
+#endif // MSG_NOSIGNAL
+				if (sent <= 0) {
+					return false;
+				}
+				p += sent;
+				size -= sent;
+			}
+			return true;
+		}
+		bool RecvAll(Socket s, void *data, size_t size) {
+			char *p = static_cast<char*>(data);
+			while (size > 0) {
+				auto received = recv(s, p, static_cast<int>(size), 0);
+				if (received <= 0) {
+					return false;
+				}
+				p += received;
+				size -= received;
+			}
+			return true;
+		}
+
+		static_assert(sizeof(ServerJobRecord) == 216, "Layout of ServerJobRecord");
+		static_assert(sizeof(ServerResultRecord) == 208, "Layout of ServerResultRecord");
+
+		// Convert GameState to and from fields of record
+		template <class Record>
+		void EncodeState(const GameState &gs, Record *record) {
+			memcpy(record->body, gs.body, sizeof(record->body));
+			record->info[0] = gs.ShotNum;
+			record->info[1] = gs.CurEnd;
+			record->info[2] = gs.LastEnd;
+			record->info[3] = gs.WhiteToMove ? 1 : 0;
+			for (unsigned int i = 0; i < kLastEndMax; i++) {
+				record->score[i] = gs.Score[i];
+			}
+		}
+		template <class Record>
+		void DecodeState(const Record &record, GameState *gs) {
+			memcpy(gs->body, record.body, sizeof(gs->body));
+			gs->ShotNum = record.info[0];
+			gs->CurEnd = record.info[1];
+			gs->LastEnd = record.info[2];
+			gs->WhiteToMove = (record.info[3] != 0);
+			for (unsigned int i = 0; i < kLastEndMax; i++) {
+				gs->Score[i] = record.score[i];
+			}
+		}
+
+		void EncodeJob(const SimJob &job, ServerJobRecord *record) {
+			record->id = job.id;
+			EncodeState(job.game_state, record);
+			record->shot[0] = job.shot_vec.x;
+			record->shot[1] = job.shot_vec.y;
+			record->shot[2] = job.shot_vec.angle ? 1.0f : 0.0f;
+			record->random_x = job.random_x;
+			record->random_y = job.random_y;
+			record->seed = job.seed;
+		}
+
+		// returns false if GameState is invalid
+		bool DecodeJob(const ServerJobRecord &record, SimJob *job) {
+			job->id = record.id;
+			DecodeState(record, &job->game_state);
+			job->shot_vec = ShotVec(record.shot[0], record.shot[1], record.shot[2] != 0.0f);
+			job->random_x = record.random_x;
+			job->random_y = record.random_y;
+			job->seed = record.seed;
+			return job->game_state.ShotNum <= 15 && IsValidState(job->game_state);
+		}
+
+		void EncodeResult(const SimResult &result, ServerResultRecord *record) {
+			record->id = result.id;
+			EncodeState(result.game_state, record);
+			record->shot[0] = result.run_shot.x;
+			record->shot[1] = result.run_shot.y;
+			record->shot[2] = result.run_shot.angle ? 1.0f : 0.0f;
+			record->steps = result.steps;
+		}
+
+		void DecodeResult(const ServerResultRecord &record, SimResult *result) {
+			result->id = record.id;
+			DecodeState(record, &result->game_state);
+			result->run_shot = ShotVec(record.shot[0], record.shot[1], record.shot[2] != 0.0f);
+			result->steps = record.steps;
+		}
+
+		// Fill sockaddr_un (returns false if path is too long)
+		bool SetAddress(const char *path, sockaddr_un *addr) {
+			memset(addr, 0x00, sizeof(sockaddr_un));
+			addr->sun_family = AF_UNIX;
+			if (strlen(path) >= sizeof(addr->sun_path)) {
+				return false;
+			}
+			strcpy(addr->sun_path, path);
+			return true;
+		}
+
+		// Client connected to server
+		//  socket is closed by reader thread after writer thread is joined
+		struct ClientConnection {
+			Socket socket;
+			unsigned int pending = 0;  // Num of jobs in Server::pending (guarded by Server::mutex)
+			std::atomic<bool> closed{ false };  // Set under mutex
+			std::mutex mutex;          // Guards members below
+			std::condition_variable cond;  // Notified when results are queued or connection is closed
+			std::deque<std::vector<ServerResultRecord>> outbound;  // Responses to send
+			size_t queued = 0;         // Num of records in outbound
+		};
+
+		// Job waiting in server
+		struct PendingJob {
+			std::shared_ptr<ClientConnection> client;
+			SimJob job;
+		};
+
+		// State of running server
+		struct Server {
+			std::mutex mutex;
+			std::condition_variable cond;   // Notified when jobs are pushed or server is stopped
+			std::condition_variable space;  // Notified when jobs are taken from pending
+			std::deque<PendingJob> pending;
+			std::vector<std::shared_ptr<ClientConnection>> clients;
+			bool stop = false;
+			Socket listen_socket = kInvalidSocket;
+		} server;
+
+		// Close connection (wakes its reader and writer)
+		//  client.mutex must be locked (server.mutex is locked after it)
+		void DropConnection(ClientConnection &client) {
+			if (client.closed) {
+				return;
+			}
+			client.closed = true;
+			client.outbound.clear();
+			client.queued = 0;
+			ShutdownSocket(client.socket);
+			client.cond.notify_all();
+			// Wake reader waiting for space
+			{
+				std::lock_guard<std::mutex> lock(server.mutex);
+			}
+			server.space.notify_all();
+		}
+
+		// Queue results to client as a response (never blocks on socket)
+		//  Drops connection if client does not read results
+		void QueueResults(ClientConnection &client, const ServerResultRecord *records, unsigned int count) {
+			{
+				std::lock_guard<std::mutex> lock(client.mutex);
+				if (client.closed) {
+					return;
+				}
+				if (client.queued + count <= kServerMaxQueuedResults) {
+					client.outbound.emplace_back(records, records + count);
+					client.queued += count;
+					client.cond.notify_all();
+					return;
+				}
+				DropConnection(client);
+			}
+		}
+
+		// Writer thread: send queued responses to a connection
+		void ServerWriter(std::shared_ptr<ClientConnection> client) {
+			std::vector<ServerResultRecord> records;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(client->mutex);
+					client->cond.wait(lock, [&]() { return client->closed || !client->outbound.empty(); });
+					if (client->closed) {
+						return;
+					}
+					records.swap(client->outbound.front());
+					client->outbound.pop_front();
+					client->queued -= records.size();
+				}
+				FrameHeader header = { kServerResponseMagic, static_cast<uint32_t>(records.size()) };
+				if (!SendAll(client->socket, &header, sizeof(header)) ||
+					!SendAll(client->socket, records.data(), sizeof(ServerResultRecord) * records.size())) {
+					std::lock_guard<std::mutex> lock(client->mutex);
+					DropConnection(*client);
+					return;
+				}
+			}
+		}
+
+		// Worker thread: run jobs in batch
+		void ServerWorker(unsigned int num_threads, unsigned int max_batch) {
+			std::vector<PendingJob> batch;
+			std::vector<ServerResultRecord> records;
+			SimResult result;
+			batch.reserve(max_batch);
+
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(server.mutex);
+					server.cond.wait(lock, []() { return server.stop || !server.pending.empty(); });
+					if (server.stop) {
+						return;
+					}
+					// Take jobs of all connections up to max_batch
+					//  (leave the rest to other workers so that a request runs on all cores)
+					size_t take = std::min<size_t>(max_batch,
+						(server.pending.size() + num_threads - 1) / num_threads);
+					while (batch.size() < take) {
+						batch.push_back(std::move(server.pending.front()));
+						server.pending.pop_front();
+						batch.back().client->pending--;
+					}
+				}
+				server.space.notify_all();
+
+				// Group by connection so that each connection gets one response per batch
+				std::stable_sort(batch.begin(), batch.end(), [](const PendingJob &a, const PendingJob &b) {
+					return a.client.get() < b.client.get();
+				});
+				records.resize(batch.size());
+				for (size_t i = 0; i < batch.size(); i++) {
+					// Skip jobs of closed connection
+					if (!batch[i].client->closed) {
+						RunJob(batch[i].job, &result);
+						EncodeResult(result, &records[i]);
+					}
+				}
+				size_t begin = 0;
+				for (size_t i = 1; i <= batch.size(); i++) {
+					if (i == batch.size() || batch[i].client != batch[begin].client) {
+						QueueResults(*batch[begin].client, &records[begin], static_cast<unsigned int>(i - begin));
+						begin = i;
+					}
+				}
+				batch.clear();
+			}
+		}
+
+		// Reader thread: receive requests from a connection
+		void ServerReader(std::shared_ptr<ClientConnection> client) {
+			std::thread writer(ServerWriter, client);
+			FrameHeader header;
+			std::vector<ServerJobRecord> records;
+			std::vector<SimJob> jobs;
+			while (RecvAll(client->socket, &header, sizeof(header))) {
+				if (header.magic != kServerRequestMagic || header.count > kServerMaxFrameJobs) {
+					break;
+				}
+				records.resize(header.count);
+				if (!RecvAll(client->socket, records.data(), sizeof(ServerJobRecord) * header.count)) {
+					break;
+				}
+				jobs.resize(header.count);
+				size_t decoded = 0;
+				while (decoded < header.count && DecodeJob(records[decoded], &jobs[decoded])) {
+					decoded++;
+				}
+				if (decoded < header.count) {
+					break;
+				}
+				{
+					// Wait until pending has room (client is blocked by socket buffer meanwhile)
+					std::unique_lock<std::mutex> lock(server.mutex);
+					server.space.wait(lock, [&]() {
+						return server.stop || client->closed ||
+							(server.pending.size() + header.count <= kServerMaxPending &&
+							client->pending + header.count <= kServerMaxConnectionPending);
+					});
+					if (server.stop || client->closed) {
+						break;
+					}
+					for (const SimJob &job : jobs) {
+						server.pending.push_back(PendingJob{ client, job });
+					}
+					client->pending += header.count;
+				}
+				server.cond.notify_all();
+			}
+
+			// Remove connection (pending results are dropped)
+			{
+				std::lock_guard<std::mutex> lock(client->mutex);
+				DropConnection(*client);
+			}
+			writer.join();
+			{
+				std::lock_guard<std::mutex> lock(server.mutex);
+				auto it = std::find(server.clients.begin(), server.clients.end(), client);
+				if (it != server.clients.end()) {
+					server.clients.erase(it);
+				}
+				CloseSocket(client->socket);
+			}
+			server.cond.notify_all();
+		}
+
+		// Run server
+		bool RunServer(const char *path, unsigned int num_threads, unsigned int max_batch) {
+			sockaddr_un addr;
+			if (!InitSocket() || !SetAddress(path, &addr)) {
+				return false;
+			}
+			Socket listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (listen_socket == kInvalidSocket) {
+				return false;
+			}
+#ifdef _WIN32
+			DeleteFileA(path);
+#else // _WIN32
+			unlink(path);
+#endif // _WIN32
+			if (bind(listen_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+				listen(listen_socket, SOMAXCONN) != 0) {
+				CloseSocket(listen_socket);
+				return false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(server.mutex);
+				server.stop = false;
+				server.listen_socket = listen_socket;
+			}
+
+			// Start worker pool
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			max_batch = std::min(std::max(max_batch, 1u), kServerMaxFrameJobs);
+			std::vector<std::thread> workers;
+			for (unsigned int i = 0; i < num_threads; i++) {
+				workers.emplace_back(ServerWorker, num_threads, max_batch);
+			}
+
+			// Accept connections until stopped
+			for (;;) {
+				Socket s = accept(listen_socket, nullptr, nullptr);
+				std::lock_guard<std::mutex> lock(server.mutex);
+				if (server.stop) {
+					if (s != kInvalidSocket) {
+						CloseSocket(s);
+					}
+					break;
+				}
+				if (s == kInvalidSocket) {
+					continue;
+				}
+				auto client = std::make_shared<ClientConnection>();
+				client->socket = s;
+				server.clients.push_back(client);
+				std::thread(ServerReader, client).detach();
+			}
+
+			// Stop workers and readers
+			{
+				std::unique_lock<std::mutex> lock(server.mutex);
+				for (auto &client : server.clients) {
+					ShutdownSocket(client->socket);
+				}
+				server.pending.clear();
+				server.cond.notify_all();
+				server.space.notify_all();
+				server.cond.wait(lock, []() { return server.clients.empty(); });
+			}
+			for (auto &t : workers) {
+				t.join();
+			}
+#ifdef _WIN32
+			// listen_socket is closed by StopServer()
+			DeleteFileA(path);
+#else // _WIN32
+			CloseSocket(listen_socket);
+			unlink(path);
+#endif // _WIN32
+
+			return true;
+		}
+
+		// Stop server running in other thread
+		void StopServer() {
+			std::lock_guard<std::mutex> lock(server.mutex);
+			server.stop = true;
+			if (server.listen_socket != kInvalidSocket) {
+				// Wake accept()
+#ifdef _WIN32
+				closesocket(server.listen_socket);
+#else // _WIN32
+				shutdown(server.listen_socket, SHUT_RDWR);
+#endif // _WIN32
+				server.listen_socket = kInvalidSocket;
+			}
+			server.cond.notify_all();
+			server.space.notify_all();
+		}
+
+		// Connection to server
+		class ServerConnection {
+		public:
+			Socket socket;
+			std::vector<ServerJobRecord> sending;
+			std::vector<ServerResultRecord> receiving;
+			std::vector<SimResult> received;  // Results not returned yet
+			size_t received_pos = 0;
+		};
+
+		// Connect to server
+		ServerConnection *ConnectServer(const char *path) {
+			sockaddr_un addr;
+			if (!InitSocket() || !SetAddress(path, &addr)) {
+				return nullptr;
+			}
+			Socket s = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (s == kInvalidSocket) {
+				return nullptr;
+			}
+			if (connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+				CloseSocket(s);
+				return nullptr;
+			}
+			ServerConnection *connection = new ServerConnection;
+			connection->socket = s;
+			return connection;
+		}
+
+		// Close connection
+		void DisconnectServer(ServerConnection *connection) {
+			if (connection == nullptr) {
+				return;
+			}
+			CloseSocket(connection->socket);
+			delete connection;
+		}
+
+		// Send jobs as a request
+		bool SendJobs(ServerConnection *connection, const SimJob *jobs, unsigned int count) {
+			while (count > 0) {
+				FrameHeader header = { kServerRequestMagic, std::min(count, kServerMaxFrameJobs) };
+				connection->sending.resize(header.count);
+				for (unsigned int i = 0; i < header.count; i++) {
+					EncodeJob(jobs[i], &connection->sending[i]);
+				}
+				if (!SendAll(connection->socket, &header, sizeof(header)) ||
+					!SendAll(connection->socket, connection->sending.data(), sizeof(ServerJobRecord) * header.count)) {
+					return false;
+				}
+				jobs += header.count;
+				count -= header.count;
+			}
+			return true;
+		}
+
+		// Receive results
+		int ReceiveResults(ServerConnection *connection, SimResult *results, unsigned int max_count) {
+			if (connection->received_pos == connection->received.size()) {
+				FrameHeader header;
+				if (!RecvAll(connection->socket, &header, sizeof(header)) ||
+					header.magic != kServerResponseMagic || header.count > kServerMaxFrameJobs) {
+					return -1;
+				}
+				connection->receiving.resize(header.count);
+				if (!RecvAll(connection->socket, connection->receiving.data(), sizeof(ServerResultRecord) * header.count)) {
+					return -1;
+				}
+				connection->received.resize(header.count);
+				connection->received_pos = 0;
+				for (unsigned int i = 0; i < header.count; i++) {
+					DecodeResult(connection->receiving[i], &connection->received[i]);
+				}
+			}
+
+			size_t count = std::min(
+				static_cast<size_t>(max_count),
+				connection->received.size() - connection->received_pos);
+			std::copy_n(connection->received.begin() + connection->received_pos, count, results);
+			connection->received_pos += count;
+
+			return static_cast<int>(count);
+		}
+#else // DCS_HAS_AF_UNIX
+		// Unix domain socket is not available with this SDK: server and connection always fail
+
+		bool RunServer(const char *path, unsigned int num_threads, unsigned int max_batch) {
+			return false;
+		}
+
+		void StopServer() {
+		}
+
+		class ServerConnection {
+		};
+
+		ServerConnection *ConnectServer(const char *path) {
+			return nullptr;
+		}
+
+		void DisconnectServer(ServerConnection *connection) {
+			delete connection;
+		}
+
+		bool SendJobs(ServerConnection *connection, const SimJob *jobs, unsigned int count) {
+			return false;
+		}
+
+		int ReceiveResults(ServerConnection *connection, SimResult *results, unsigned int max_count) {
+			return -1;
+		}
+#endif // DCS_HAS_AF_UNIX
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Local simulation server
+//  Server accepts SimJob over Unix domain socket, runs them in its worker pool
+//  and streams SimResult back. Start server with
+//      DCSimulator server <path> [num_threads]
+//
+//  Protocol (little endian):
+//      request  : FrameHeader(kServerRequestMagic, n), ServerJobRecord[n]
+//      response : FrameHeader(kServerResponseMagic, n), ServerResultRecord[n]
+//  Results of a request can be split into several responses and may be out of order.
+//  Server closes connection if a request has invalid GameState
+//  (ShotNum > 15, CurEnd >= kLastEndMax or LastEnd > kLastEndMax).
+//
+//  Client must read responses while it sends requests. Server stops reading
+//  requests of a connection while kServerMaxConnectionPending of its jobs are
+//  waiting, and closes the connection if more than kServerMaxQueuedResults of
+//  its results cannot be sent because client does not read them.
+//  On Windows, server needs to be built with Windows 10 SDK 10.0.17134 or later
+//  (afunix.h); otherwise RunServer() and ConnectServer() always fail.
+
+#include "dcurling_simulator.h"
+
+#include <cstdint>
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr unsigned int kServerRequestMagic  = 0x51534344;  // "DCSQ"
+		constexpr unsigned int kServerResponseMagic = 0x52534344;  // "DCSR"
+		constexpr unsigned int kServerMaxFrameJobs  = 65536;       // Max num of jobs in a frame
+		constexpr unsigned int kServerMaxPending    = 4 * kServerMaxFrameJobs;  // Max num of jobs waiting in server
+		constexpr unsigned int kServerMaxConnectionPending = kServerMaxFrameJobs;  // Max num of jobs of a connection waiting in server
+		constexpr unsigned int kServerMaxQueuedResults = 2 * kServerMaxFrameJobs;  // Max num of results of a connection waiting to be sent
+
+		// Header of frame
+		struct FrameHeader {
+			uint32_t magic;
+			uint32_t count;    // Num of records which follows
+		};
+
+		// Record of SimJob in request
+		struct ServerJobRecord {
+			uint64_t id;
+			float body[16][2];
+			int32_t info[4];   // ShotNum, CurEnd, LastEnd, WhiteToMove
+			int32_t score[kLastEndMax];
+			float shot[3];     // x, y, angle (0: false, otherwise true)
+			float random_x;
+			float random_y;
+			uint32_t seed;     // 0: non-deterministic
+		};
+
+		// Record of SimResult in response
+		struct ServerResultRecord {
+			uint64_t id;
+			float body[16][2];
+			int32_t info[4];   // ShotNum, CurEnd, LastEnd, WhiteToMove
+			int32_t score[kLastEndMax];
+			float shot[3];     // Shot with random number
+			int32_t steps;
+		};
+
+		// Run server (blocks until StopServer() is called)
+		//  path        : path of Unix domain socket (removed and created)
+		//  num_threads : num of threads in worker pool (0: num of cores)
+		//  max_batch   : max num of jobs taken by a worker at once
+		//                (pending jobs are shared by all workers)
+		//  returns false if socket could not be opened
+		DLLEXP bool RunServer(const char *path, unsigned int num_threads, unsigned int max_batch);
+
+		// Stop server running in other thread
+		DLLEXP void StopServer();
+
+		// Connection to server (opaque)
+		class ServerConnection;
+
+		// Connect to server (returns nullptr if failed)
+		DLLEXP ServerConnection *ConnectServer(const char *path);
+
+		// Close connection
+		DLLEXP void DisconnectServer(ServerConnection *connection);
+
+		// Send jobs as a request
+		//  Blocks while server does not read; when sending more than
+		//  kServerMaxQueuedResults jobs, call ReceiveResults() in other thread meanwhile
+		//  returns false if connection is closed
+		DLLEXP bool SendJobs(ServerConnection *connection, const SimJob *jobs, unsigned int count);
+
+		// Receive results (waits until at least one result is received)
+		//  returns num of results stored to results (up to max_count), -1 if connection is closed
+		DLLEXP int ReceiveResults(ServerConnection *connection, SimResult *results, unsigned int max_count);
+	}
+}
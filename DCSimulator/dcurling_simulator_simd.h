@@ -0,0 +1,141 @@
+#pragma once
+
+// SIMD vector types and vectorized kernels of the simulator
+//  A vector type has static functions on floats in lanes (Type) and on lane masks
+//  (Type with all bits set in true lanes), so kernels are written once as templates.
+//  Note: Not a part of exported API
+
+#include "dcurling_simulator_internal.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Box2D/Common/b2Settings.h"
+
+#ifdef b2_useSSE2
+#include <emmintrin.h>
+#endif // b2_useSSE2
+#ifdef _WIN32
+#include <intrin.h>
+#endif // _WIN32
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		// Index of lowest set bit (mask must not be 0)
+		inline unsigned int LowestBit(unsigned int mask) {
+#ifdef _WIN32
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else // _WIN32
+			return __builtin_ctz(mask);
+#endif // _WIN32
+		}
+
+		namespace simd {
+
+			// 1 lane (used if no SIMD is available)
+			struct Scalar {
+				typedef float Type;
+				static constexpr int kWidth = 1;
+
+				static Type Zero() { return 0.0f; }
+				static Type Set(float a) { return a; }
+				static Type Load(const float *p) { return *p; }
+				static void Store(float *p, Type a) { *p = a; }
+
+				static Type Add(Type a, Type b) { return a + b; }
+				static Type Sub(Type a, Type b) { return a - b; }
+				static Type Mul(Type a, Type b) { return a * b; }
+				static Type Div(Type a, Type b) { return a / b; }
+				static Type Sqrt(Type a) { return std::sqrt(a); }
+				static Type Min(Type a, Type b) { return (a < b) ? a : b; }
+				static Type Max(Type a, Type b) { return (a > b) ? a : b; }
+
+				static Type And(Type a, Type b) { return FromBits(Bits(a) & Bits(b)); }
+				static Type AndNot(Type a, Type b) { return FromBits(~Bits(a) & Bits(b)); }  // ~a & b
+				static Type Or(Type a, Type b) { return FromBits(Bits(a) | Bits(b)); }
+				static Type Xor(Type a, Type b) { return FromBits(Bits(a) ^ Bits(b)); }
+				static Type Select(Type mask, Type a, Type b) { return Or(And(mask, a), AndNot(mask, b)); }
+
+				static Type CmpLt(Type a, Type b) { return FromBool(a < b); }
+				static Type CmpLe(Type a, Type b) { return FromBool(a <= b); }
+				static Type CmpGt(Type a, Type b) { return FromBool(a > b); }
+				static Type CmpEq(Type a, Type b) { return FromBool(a == b); }
+				static Type CmpNeq(Type a, Type b) { return FromBool(a != b); }
+				static Type CmpNlt(Type a, Type b) { return FromBool(!(a < b)); }
+
+				// Bits of lanes in mask (bit i: lane i)
+				static int Mask(Type mask) { return Bits(mask) >> 31; }
+				// Lane mask from bits
+				static Type FromMask(int bits) { return FromBool((bits & 1) != 0); }
+
+			private:
+				static uint32_t Bits(Type a) {
+					uint32_t bits;
+					memcpy(&bits, &a, sizeof(bits));
+					return bits;
+				}
+				static Type FromBits(uint32_t bits) {
+					Type a;
+					memcpy(&a, &bits, sizeof(a));
+					return a;
+				}
+				static Type FromBool(bool flag) { return FromBits(flag ? 0xFFFFFFFFu : 0u); }
+			};
+
+#ifdef b2_useSSE2
+			// 4 lanes of SSE2
+			struct Sse2 {
+				typedef __m128 Type;
+				static constexpr int kWidth = 4;
+
+				static Type Zero() { return _mm_setzero_ps(); }
+				static Type Set(float a) { return _mm_set1_ps(a); }
+				static Type Load(const float *p) { return _mm_load_ps(p); }
+				static void Store(float *p, Type a) { _mm_store_ps(p, a); }
+
+				static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+				static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+				static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+				static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+				static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+				static Type Min(Type a, Type b) { return _mm_min_ps(a, b); }
+				static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+
+				static Type And(Type a, Type b) { return _mm_and_ps(a, b); }
+				static Type AndNot(Type a, Type b) { return _mm_andnot_ps(a, b); }  // ~a & b
+				static Type Or(Type a, Type b) { return _mm_or_ps(a, b); }
+				static Type Xor(Type a, Type b) { return _mm_xor_ps(a, b); }
+				static Type Select(Type mask, Type a, Type b) { return Or(And(mask, a), AndNot(mask, b)); }
+
+				static Type CmpLt(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+				static Type CmpLe(Type a, Type b) { return _mm_cmple_ps(a, b); }
+				static Type CmpGt(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+				static Type CmpEq(Type a, Type b) { return _mm_cmpeq_ps(a, b); }
+				static Type CmpNeq(Type a, Type b) { return _mm_cmpneq_ps(a, b); }
+				static Type CmpNlt(Type a, Type b) { return _mm_cmpnlt_ps(a, b); }
+
+				// Bits of lanes in mask (bit i: lane i)
+				static int Mask(Type mask) { return _mm_movemask_ps(mask); }
+				// Lane mask from bits
+				static Type FromMask(int bits) {
+					const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+					return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lanes), lanes));
+				}
+			};
+
+			// Widest vector type of this build
+			typedef Sse2 Native;
+#else // b2_useSSE2
+			typedef Scalar Native;
+#endif // b2_useSSE2
+
+			// Kernels of vector types of this build
+#include "dcurling_simulator_simd_kernels.inl"
+		}
+	}
+}
@@ -0,0 +1,46 @@
+// Vectorized kernels (templates on vector type V)
+//  No include guard: included in namespace simd for vector types of the build
+//  and in a namespace of each instruction set (dcurling_simulator_lockstep_<isa>.cpp),
+//  so kernels are compiled for the instruction set of their vector type.
+//  Note: Not a part of exported API
+
+			// Add friction to stones in lanes
+			//  Same operations as FrictionStep in each lane, so results are bit-identical.
+			//  vx, vy : velocities, updated
+			//  angle  : angular velocities (only signs are used)
+			template <class V>
+			inline void Friction(typename V::Type friction, typename V::Type angle,
+				typename V::Type &vx, typename V::Type &vy) {
+				typedef typename V::Type Vec;
+				const Vec zero = V::Zero();
+				const Vec sign = V::Set(-0.0f);
+				Vec x = vx;
+				Vec y = vy;
+
+				// Stones slower than friction are stopped
+				Vec length = V::Sqrt(V::Add(V::Mul(x, x), V::Mul(y, y)));
+				Vec slide = V::CmpGt(length, friction);
+
+				// Subtract friction along velocity
+				Vec nx = V::Div(x, length);
+				Vec ny = V::Div(y, length);
+				Vec rx = V::Sub(x, V::Mul(nx, friction));
+				Vec ry = V::Sub(y, V::Mul(ny, friction));
+
+				// Add vertical force to stones which have angle != 0
+				Vec k = V::Mul(friction, V::Set(kStandardAngle));
+				k = V::Select(V::CmpGt(angle, zero), V::Xor(k, sign), k);
+				Vec cx = V::Add(rx, V::Mul(ny, k));
+				Vec cy = V::Add(ry, V::Mul(V::Xor(ny, sign), k));
+				Vec rlength = V::Sqrt(V::Add(V::Mul(rx, rx), V::Mul(ry, ry)));
+				// Normalize again (as b2Vec2::Normalize) and reform
+				Vec clength = V::Sqrt(V::Add(V::Mul(cx, cx), V::Mul(cy, cy)));
+				Vec inv = V::Div(V::Set(1.0f), clength);
+				Vec normalize = V::CmpNlt(clength, V::Set(b2_epsilon));
+				cx = V::Mul(V::Select(normalize, V::Mul(cx, inv), cx), rlength);
+				cy = V::Mul(V::Select(normalize, V::Mul(cy, inv), cy), rlength);
+				Vec curl = V::CmpNeq(angle, zero);
+
+				vx = V::And(slide, V::Select(curl, cx, rx));
+				vy = V::And(slide, V::Select(curl, cy, ry));
+			}
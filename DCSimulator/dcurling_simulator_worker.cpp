@@ -0,0 +1,764 @@
+// Multi-process worker mode
+//  Layout of shared memory: ChannelHeader, JobCell[capacity], ResultCell[capacity]
+//  Both rings are bounded MPMC queues (sequence number per cell),
+//  so any number of clients and workers can push / pop without locks.
+//  Waiting sides sleep on futex words in shared memory (Linux) or on named
+//  semaphores (Windows), other platforms poll with short sleep.
+//  Each worker has a slot in the header with a heartbeat and a journal of
+//  the job it holds and the cells it is claiming. Client checks heartbeats
+//  while it waits, fails jobs of dead workers and releases their cells.
+#include "dcurling_simulator_worker.h"
+#include "dcurling_simulator_internal.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif // __linux__
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr uint32_t kChannelMagic = 0x43574344;  // "DCWC"
+		constexpr size_t kCacheLine = 64;
+		constexpr int kAttachTimeoutMs = 10000;  // Time for worker to wait until channel is initialized
+		constexpr int kHeartbeatMs = 100;        // Interval of heartbeat of worker
+		constexpr int kReapIntervalMs = 500;     // Interval of client to check heartbeats while waiting
+		constexpr uint64_t kCellLocked = ~0ull;  // seq of cell being released by client
+
+		// Event which waiting side can sleep on
+		struct ShmEvent {
+			std::atomic<uint32_t> count;    // Incremented on each notification (futex word)
+			std::atomic<uint32_t> waiters;  // Num of sleeping threads
+		};
+
+		// Positions of ring buffer
+		struct RingHeader {
+			alignas(kCacheLine) std::atomic<uint64_t> enqueue_pos;
+			alignas(kCacheLine) std::atomic<uint64_t> dequeue_pos;
+			alignas(kCacheLine) ShmEvent pushed;  // Notified when an item is pushed
+			alignas(kCacheLine) ShmEvent popped;  // Notified when an item is popped
+		};
+
+		template <class T>
+		struct RingCell {
+			std::atomic<uint64_t> seq;
+			T data;
+		};
+		typedef RingCell<SimJob> JobCell;
+		typedef RingCell<SimResult> ResultCell;
+
+		// State of WorkerSlot
+		enum SlotState : uint32_t {
+			kSlotFree = 0,
+			kSlotClaiming,  // Being initialized by a worker
+			kSlotActive,    // Used by a worker
+			kSlotReaping    // Worker is dead, being cleaned up by client
+		};
+
+		// Slot of a worker
+		//  pop_pos / push_pos are set before claiming a cell and cleared after it is
+		//  released, so that client can release a cell claimed by a dead worker.
+		//  (other workers may have the same position for a moment, then fail to claim it)
+		struct alignas(kCacheLine) WorkerSlot {
+			std::atomic<uint32_t> state;
+			std::atomic<uint32_t> generation;  // Incremented when slot is freed
+			std::atomic<uint64_t> heartbeat;   // Time in ms (NowMs()) updated by worker
+			std::atomic<uint64_t> pop_pos;     // Position + 1 of job cell being popped (0: none)
+			std::atomic<uint64_t> push_pos;    // Position + 1 of result cell being pushed (0: none)
+			std::atomic<uint32_t> has_job;     // 1 from job is popped until its result is pushed
+			SimJob job;                        // Job popped by worker
+		};
+
+		struct ChannelHeader {
+			std::atomic<uint32_t> magic;     // kChannelMagic after initialized
+			uint32_t capacity;
+			std::atomic<uint32_t> shutdown;  // Set by DestroyWorkerChannel()
+			RingHeader jobs;
+			RingHeader results;
+			WorkerSlot workers[kMaxWorkers];
+		};
+
+		// Event of channel in this process
+		struct ChannelEvent {
+			ShmEvent *shm = nullptr;
+#ifdef _WIN32
+			HANDLE semaphore = nullptr;  // Released once for each waiter on notification
+#endif // _WIN32
+		};
+
+		// Shared memory mapped in this process
+		class WorkerChannel {
+		public:
+			ChannelHeader *header = nullptr;
+			JobCell *jobs = nullptr;
+			ResultCell *results = nullptr;
+			size_t size = 0;
+			std::string name;
+			bool owner = false;  // true if created by this process
+			ChannelEvent job_pushed;
+			ChannelEvent job_popped;
+			ChannelEvent result_pushed;
+			ChannelEvent result_popped;
+#ifdef _WIN32
+			HANDLE mapping = nullptr;
+#endif // _WIN32
+
+			// Client only
+			std::mutex mutex;  // Guards members below
+			std::unordered_map<unsigned long long, SimJob> in_flight;  // Jobs submitted and not received
+			std::deque<SimResult> lost;  // Results of jobs of dead workers
+			std::atomic<uint64_t> last_reap{ 0 };  // Time of last ReapWorkers()
+		};
+
+		// Time in ms shared by processes
+		inline uint64_t NowMs() {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		inline size_t GetChannelSize(uint32_t capacity) {
+			return sizeof(ChannelHeader) + (sizeof(JobCell) + sizeof(ResultCell)) * capacity;
+		}
+
+		inline void SetCells(WorkerChannel *channel) {
+			channel->jobs = reinterpret_cast<JobCell*>(channel->header + 1);
+			channel->results = reinterpret_cast<ResultCell*>(channel->jobs + channel->header->capacity);
+		}
+
+		// Sleep until event is notified after count was read (or timeout)
+		void WaitEvent(ChannelEvent &event, uint32_t count, int timeout_ms) {
+#if defined(_WIN32)
+			// Notification after count was read leaves the semaphore signaled
+			if (event.shm->count.load() == count) {
+				WaitForSingleObject(event.semaphore, (timeout_ms < 0) ? INFINITE : static_cast<DWORD>(timeout_ms));
+			}
+#elif defined(__linux__)
+			struct timespec ts;
+			ts.tv_sec = timeout_ms / 1000;
+			ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&event.shm->count), FUTEX_WAIT,
+				count, (timeout_ms < 0) ? nullptr : &ts, nullptr, 0);
+#else
+			(void)count;
+			(void)timeout_ms;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+		}
+
+		// Wake threads sleeping on event
+		void NotifyEvent(ChannelEvent &event) {
+			event.shm->count.fetch_add(1);
+#if defined(_WIN32)
+			// A waiter which has timed out may leave a count (next wait returns at once)
+			LONG waiters = static_cast<LONG>(event.shm->waiters.load());
+			if (waiters > 0) {
+				ReleaseSemaphore(event.semaphore, waiters, nullptr);
+			}
+#elif defined(__linux__)
+			if (event.shm->waiters.load() > 0) {
+				syscall(SYS_futex, reinterpret_cast<uint32_t*>(&event.shm->count), FUTEX_WAKE,
+					INT_MAX, nullptr, nullptr, 0);
+			}
+#endif
+		}
+
+		// Try to push item to ring (returns false if full)
+		//  journal : set to position + 1 while claiming a cell (worker only)
+		template <class T>
+		bool TryPush(RingHeader &ring, RingCell<T> *cells, uint32_t capacity, const T &item, ChannelEvent &pushed,
+			std::atomic<uint64_t> *journal = nullptr) {
+			const uint64_t mask = capacity - 1;
+			uint64_t pos = ring.enqueue_pos.load(std::memory_order_relaxed);
+			RingCell<T> *cell;
+			for (;;) {
+				cell = &cells[pos & mask];
+				uint64_t seq = cell->seq.load(std::memory_order_acquire);
+				int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+				if (diff == 0) {
+					if (journal != nullptr) {
+						journal->store(pos + 1);
+					}
+					if (ring.enqueue_pos.compare_exchange_strong(pos, pos + 1)) {
+						break;
+					}
+					if (journal != nullptr) {
+						journal->store(0);
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = ring.enqueue_pos.load(std::memory_order_relaxed);
+				}
+			}
+			cell->data = item;
+			// Cell may have been released by client if this worker was stalled and taken as dead
+			uint64_t expected = pos;
+			bool released = cell->seq.compare_exchange_strong(expected, pos + 1, std::memory_order_release);
+			if (journal != nullptr) {
+				journal->store(0);
+			}
+			if (released) {
+				NotifyEvent(pushed);
+			}
+			return true;
+		}
+
+		// Try to pop item from ring (returns false if empty)
+		//  journal : set to position + 1 while claiming a cell (worker only)
+		//  taken   : set to 1 after item is copied (worker only)
+		template <class T>
+		bool TryPop(RingHeader &ring, RingCell<T> *cells, uint32_t capacity, T *item, ChannelEvent &popped,
+			std::atomic<uint64_t> *journal = nullptr, std::atomic<uint32_t> *taken = nullptr) {
+			const uint64_t mask = capacity - 1;
+			uint64_t pos = ring.dequeue_pos.load(std::memory_order_relaxed);
+			RingCell<T> *cell;
+			for (;;) {
+				cell = &cells[pos & mask];
+				uint64_t seq = cell->seq.load(std::memory_order_acquire);
+				int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+				if (diff == 0) {
+					if (journal != nullptr) {
+						journal->store(pos + 1);
+					}
+					if (ring.dequeue_pos.compare_exchange_strong(pos, pos + 1)) {
+						break;
+					}
+					if (journal != nullptr) {
+						journal->store(0);
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = ring.dequeue_pos.load(std::memory_order_relaxed);
+				}
+			}
+			*item = cell->data;
+			if (taken != nullptr) {
+				taken->store(1);
+			}
+			uint64_t expected = pos + 1;
+			bool released = cell->seq.compare_exchange_strong(expected, pos + mask + 1, std::memory_order_release);
+			if (journal != nullptr) {
+				journal->store(0);
+			}
+			if (released) {
+				NotifyEvent(popped);
+			}
+			return true;
+		}
+
+		// Retry op until it succeeds, sleeping on event between retries
+		//  returns false if timed out or channel is shut down
+		template <class Op>
+		bool WaitFor(ChannelHeader *header, ChannelEvent &event, int timeout_ms, Op op) {
+			if (op()) {
+				return true;
+			}
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+			while (timeout_ms != 0 && header->shutdown.load() == 0) {
+				int wait_ms = -1;
+				if (timeout_ms > 0) {
+					auto rest = std::chrono::duration_cast<std::chrono::milliseconds>(
+						deadline - std::chrono::steady_clock::now()).count();
+					if (rest <= 0) {
+						break;
+					}
+					wait_ms = static_cast<int>(rest);
+				}
+
+				// Check shutdown again after registered as a waiter,
+				// otherwise notification of DestroyWorkerChannel() may be lost
+				event.shm->waiters.fetch_add(1);
+				uint32_t count = event.shm->count.load();
+				bool done = op();
+				if (!done && header->shutdown.load() == 0) {
+					WaitEvent(event, count, wait_ms);
+				}
+				event.shm->waiters.fetch_sub(1);
+				if (done || op()) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Map shared memory (create = true: create new one)
+		bool MapChannel(WorkerChannel *channel, bool create, size_t size) {
+#ifdef _WIN32
+			std::string name = "Local\\dcsim_" + channel->name;
+			HANDLE mapping;
+			if (create) {
+				mapping = CreateFileMappingA(
+					INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+					static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+					static_cast<DWORD>(size & 0xFFFFFFFF), name.c_str());
+				if (mapping != nullptr && GetLastError() == ERROR_ALREADY_EXISTS) {
+					CloseHandle(mapping);
+					return false;
+				}
+			}
+			else {
+				mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+			}
+			if (mapping == nullptr) {
+				return false;
+			}
+			void *addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+			if (addr == nullptr) {
+				CloseHandle(mapping);
+				return false;
+			}
+			channel->mapping = mapping;
+#else // _WIN32
+			std::string name = "/dcsim_" + channel->name;
+			int fd = create ?
+				shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600) :
+				shm_open(name.c_str(), O_RDWR, 0);
+			if (fd < 0) {
+				return false;
+			}
+			if (create && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+				close(fd);
+				shm_unlink(name.c_str());
+				return false;
+			}
+			// Creator may not have resized it yet (access beyond the end raises SIGBUS)
+			struct stat st;
+			if (!create && (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < size)) {
+				close(fd);
+				return false;
+			}
+			void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (addr == MAP_FAILED) {
+				if (create) {
+					shm_unlink(name.c_str());
+				}
+				return false;
+			}
+#endif // _WIN32
+			channel->header = static_cast<ChannelHeader*>(addr);
+			channel->size = size;
+			channel->owner = create;
+			return true;
+		}
+
+		// Set events of mapped channel (create = true: create semaphores)
+		bool OpenEvents(WorkerChannel *channel, bool create) {
+			ChannelEvent *events[] = {
+				&channel->job_pushed, &channel->job_popped, &channel->result_pushed, &channel->result_popped };
+			ShmEvent *shm[] = {
+				&channel->header->jobs.pushed, &channel->header->jobs.popped,
+				&channel->header->results.pushed, &channel->header->results.popped };
+			for (int i = 0; i < 4; i++) {
+				events[i]->shm = shm[i];
+#ifdef _WIN32
+				std::string name = "Local\\dcsim_" + channel->name + "_" + std::to_string(i);
+				events[i]->semaphore = create ?
+					CreateSemaphoreA(nullptr, 0, LONG_MAX, name.c_str()) :
+					OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, FALSE, name.c_str());
+				if (events[i]->semaphore == nullptr) {
+					return false;
+				}
+#endif // _WIN32
+			}
+			return true;
+		}
+
+		void CloseEvents(WorkerChannel *channel) {
+#ifdef _WIN32
+			ChannelEvent *events[] = {
+				&channel->job_pushed, &channel->job_popped, &channel->result_pushed, &channel->result_popped };
+			for (ChannelEvent *event : events) {
+				if (event->semaphore != nullptr) {
+					CloseHandle(event->semaphore);
+					event->semaphore = nullptr;
+				}
+			}
+#else // _WIN32
+			(void)channel;
+#endif // _WIN32
+		}
+
+		void UnmapChannel(WorkerChannel *channel) {
+#ifdef _WIN32
+			UnmapViewOfFile(channel->header);
+			CloseHandle(channel->mapping);
+#else // _WIN32
+			munmap(channel->header, channel->size);
+			if (channel->owner) {
+				shm_unlink(("/dcsim_" + channel->name).c_str());
+			}
+#endif // _WIN32
+			channel->header = nullptr;
+		}
+
+		// Create channel in shared memory
+		WorkerChannel *CreateWorkerChannel(const char *name, unsigned int capacity) {
+			if (name == nullptr || capacity == 0 || capacity > (1u << 24)) {
+				return nullptr;
+			}
+			uint32_t capacity_pow2 = 1;
+			while (capacity_pow2 < capacity) {
+				capacity_pow2 <<= 1;
+			}
+
+			WorkerChannel *channel = new WorkerChannel;
+			channel->name = name;
+			if (!MapChannel(channel, true, GetChannelSize(capacity_pow2))) {
+				delete channel;
+				return nullptr;
+			}
+			if (!OpenEvents(channel, true)) {
+				CloseEvents(channel);
+				UnmapChannel(channel);
+				delete channel;
+				return nullptr;
+			}
+
+			// Initialize rings (memory of new mapping is zero filled)
+			ChannelHeader *header = channel->header;
+			header->capacity = capacity_pow2;
+			SetCells(channel);
+			for (uint32_t i = 0; i < capacity_pow2; i++) {
+				new (&channel->jobs[i]) JobCell();
+				new (&channel->results[i]) ResultCell();
+				channel->jobs[i].seq.store(i, std::memory_order_relaxed);
+				channel->results[i].seq.store(i, std::memory_order_relaxed);
+			}
+			for (WorkerSlot &slot : header->workers) {
+				new (&slot) WorkerSlot();
+				slot.state.store(kSlotFree, std::memory_order_relaxed);
+			}
+			header->magic.store(kChannelMagic, std::memory_order_release);
+
+			return channel;
+		}
+
+		// Stop workers and destroy channel
+		void DestroyWorkerChannel(WorkerChannel *channel) {
+			if (channel == nullptr) {
+				return;
+			}
+			channel->header->shutdown.store(1);
+			NotifyEvent(channel->job_pushed);
+			NotifyEvent(channel->result_popped);
+			CloseEvents(channel);
+			UnmapChannel(channel);
+			delete channel;
+		}
+
+		// true if a live worker other than dead is claiming the cell at pos (journal of WorkerSlot)
+		bool IsClaimedByLiveWorker(ChannelHeader *header, const WorkerSlot &dead,
+			std::atomic<uint64_t> WorkerSlot::*journal, uint64_t pos, uint64_t now) {
+			for (const WorkerSlot &slot : header->workers) {
+				if (&slot != &dead && slot.state.load() == kSlotActive &&
+					now < slot.heartbeat.load() + kWorkerLeaseMs && (slot.*journal).load() == pos + 1) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Move job to lost results if it is in flight (client only, locked)
+		void FailJob(WorkerChannel *channel, unsigned long long id) {
+			auto it = channel->in_flight.find(id);
+			if (it == channel->in_flight.end()) {
+				return;
+			}
+			SimResult result;
+			result.id = id;
+			result.game_state = it->second.game_state;
+			result.run_shot = it->second.shot_vec;
+			result.steps = kWorkerLostSteps;
+			channel->lost.push_back(result);
+			channel->in_flight.erase(it);
+		}
+
+		// Fail jobs of dead workers and release cells they were claiming
+		void ReapWorkers(WorkerChannel *channel) {
+			ChannelHeader *header = channel->header;
+			const uint64_t mask = header->capacity - 1;
+			uint64_t now = NowMs();
+			channel->last_reap.store(now);
+			for (WorkerSlot &slot : header->workers) {
+				uint32_t state = kSlotActive;
+				if (slot.state.load() != kSlotActive || now < slot.heartbeat.load() + kWorkerLeaseMs ||
+					!slot.state.compare_exchange_strong(state, kSlotReaping)) {
+					continue;
+				}
+
+				// Cell claimed by dead worker is stuck if it is claimed (position < dequeue_pos or
+				// enqueue_pos) and not released (seq is not updated)
+				uint64_t pop_pos = slot.pop_pos.load();
+				uint64_t push_pos = slot.push_pos.load();
+				JobCell *job_cell = nullptr;
+				ResultCell *result_cell = nullptr;
+				if (pop_pos != 0) {
+					uint64_t pos = pop_pos - 1;
+					JobCell &cell = channel->jobs[pos & mask];
+					if (cell.seq.load() == pos + 1 && header->jobs.dequeue_pos.load() > pos) {
+						job_cell = &cell;
+					}
+				}
+				if (push_pos != 0) {
+					uint64_t pos = push_pos - 1;
+					ResultCell &cell = channel->results[pos & mask];
+					if (cell.seq.load() == pos && header->results.enqueue_pos.load() > pos) {
+						result_cell = &cell;
+					}
+				}
+				// Owner of stuck cell may be a live worker, check again later
+				if ((job_cell != nullptr && IsClaimedByLiveWorker(header, slot, &WorkerSlot::pop_pos, pop_pos - 1, now)) ||
+					(result_cell != nullptr && IsClaimedByLiveWorker(header, slot, &WorkerSlot::push_pos, push_pos - 1, now))) {
+					slot.state.store(kSlotActive);
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(channel->mutex);
+					// Job is failed even if its result was pushed just before worker died
+					// (then the result is dropped by ReceiveResult)
+					if (slot.has_job.load() != 0) {
+						FailJob(channel, slot.job.id);
+					}
+					if (job_cell != nullptr) {
+						// Release as popped (seq: position + 1 -> position + capacity)
+						unsigned long long id = job_cell->data.id;
+						uint64_t expected = pop_pos;
+						if (job_cell->seq.compare_exchange_strong(expected, pop_pos + mask)) {
+							FailJob(channel, id);
+							NotifyEvent(channel->job_popped);
+						}
+					}
+				}
+				if (result_cell != nullptr) {
+					// Release as pushed with result of the failed job (dropped by ReceiveResult)
+					//  Cell is locked while writing, so a stalled worker cannot release it.
+					uint64_t expected = push_pos - 1;
+					if (result_cell->seq.compare_exchange_strong(expected, kCellLocked)) {
+						result_cell->data.id = slot.job.id;
+						result_cell->data.steps = kWorkerLostSteps;
+						result_cell->seq.store(push_pos);
+						NotifyEvent(channel->result_pushed);
+					}
+				}
+
+				slot.pop_pos.store(0);
+				slot.push_pos.store(0);
+				slot.has_job.store(0);
+				slot.generation.fetch_add(1);
+				slot.state.store(kSlotFree);
+			}
+		}
+
+		// WaitFor of client
+		//  Heartbeats of workers are checked at intervals while waiting
+		template <class Op>
+		bool ClientWaitFor(WorkerChannel *channel, ChannelEvent &event, int timeout_ms, Op op) {
+			// Reap also while busy, as other workers may keep results coming
+			if (NowMs() >= channel->last_reap.load() + kReapIntervalMs) {
+				ReapWorkers(channel);
+			}
+			auto start = std::chrono::steady_clock::now();
+			for (;;) {
+				int wait_ms = kReapIntervalMs;
+				if (timeout_ms >= 0) {
+					auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+						std::chrono::steady_clock::now() - start).count();
+					wait_ms = static_cast<int>(std::max<long long>(0, std::min<long long>(wait_ms, timeout_ms - elapsed)));
+				}
+				if (WaitFor(channel->header, event, wait_ms, op)) {
+					return true;
+				}
+				if (wait_ms < kReapIntervalMs) {
+					return false;
+				}
+				ReapWorkers(channel);
+			}
+		}
+
+		// Push job to channel
+		bool SubmitJob(WorkerChannel *channel, const SimJob &job, int timeout_ms) {
+			{
+				std::lock_guard<std::mutex> lock(channel->mutex);
+				if (!channel->in_flight.emplace(job.id, job).second) {
+					return false;
+				}
+			}
+			ChannelHeader *header = channel->header;
+			bool pushed = ClientWaitFor(channel, channel->job_popped, timeout_ms, [&]() {
+				return TryPush(header->jobs, channel->jobs, header->capacity, job, channel->job_pushed);
+			});
+			if (!pushed) {
+				std::lock_guard<std::mutex> lock(channel->mutex);
+				channel->in_flight.erase(job.id);
+			}
+			return pushed;
+		}
+
+		// Pop result from channel
+		bool ReceiveResult(WorkerChannel *channel, SimResult* const result, int timeout_ms) {
+			ChannelHeader *header = channel->header;
+			return ClientWaitFor(channel, channel->result_pushed, timeout_ms, [&]() {
+				for (;;) {
+					{
+						std::lock_guard<std::mutex> lock(channel->mutex);
+						if (!channel->lost.empty()) {
+							*result = channel->lost.front();
+							channel->lost.pop_front();
+							return true;
+						}
+					}
+					if (!TryPop(header->results, channel->results, header->capacity, result, channel->result_popped)) {
+						return false;
+					}
+					// Drop result of job which was failed as lost
+					std::lock_guard<std::mutex> lock(channel->mutex);
+					if (channel->in_flight.erase(result->id) != 0) {
+						return true;
+					}
+				}
+			});
+		}
+
+		// Main loop of worker process
+		int RunWorker(const char *name) {
+			WorkerChannel channel;
+			channel.name = name;
+
+			// Map header first to know capacity
+			//  Retry until creator has resized and initialized it
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kAttachTimeoutMs);
+			for (;;) {
+				if (MapChannel(&channel, false, sizeof(ChannelHeader))) {
+					if (channel.header->magic.load(std::memory_order_acquire) == kChannelMagic) {
+						break;
+					}
+					UnmapChannel(&channel);
+				}
+				if (std::chrono::steady_clock::now() >= deadline) {
+					return 1;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			uint32_t capacity = channel.header->capacity;
+			UnmapChannel(&channel);
+			if (!MapChannel(&channel, false, GetChannelSize(capacity))) {
+				return 1;
+			}
+			SetCells(&channel);
+			if (!OpenEvents(&channel, false)) {
+				CloseEvents(&channel);
+				UnmapChannel(&channel);
+				return 1;
+			}
+
+			ChannelHeader *header = channel.header;
+
+			// Take a free slot
+			WorkerSlot *slot = nullptr;
+			for (WorkerSlot &s : header->workers) {
+				uint32_t state = kSlotFree;
+				if (s.state.compare_exchange_strong(state, kSlotClaiming)) {
+					slot = &s;
+					break;
+				}
+			}
+			if (slot == nullptr) {
+				CloseEvents(&channel);
+				UnmapChannel(&channel);
+				return 1;
+			}
+			const uint32_t generation = slot->generation.load();
+			slot->heartbeat.store(NowMs());
+			slot->pop_pos.store(0);
+			slot->push_pos.store(0);
+			slot->has_job.store(0);
+			slot->state.store(kSlotActive);
+
+			// Heartbeat is sent by another thread, so a long job is not taken as dead
+			std::atomic<bool> stop(false);
+			std::thread heartbeat([&]() {
+				while (!stop.load()) {
+					slot->heartbeat.store(NowMs());
+					std::this_thread::sleep_for(std::chrono::milliseconds(kHeartbeatMs));
+				}
+			});
+			// false if client took this worker as dead (while it was stalled)
+			auto alive = [&]() {
+				return slot->generation.load() == generation && slot->state.load() == kSlotActive;
+			};
+
+			SimJob job;
+			SimResult result;
+			int ret = 0;
+			while (header->shutdown.load() == 0) {
+				if (!WaitFor(header, channel.job_pushed, -1, [&]() {
+					return TryPop(header->jobs, channel.jobs, capacity, &slot->job, channel.job_popped,
+						&slot->pop_pos, &slot->has_job);
+				})) {
+					break;
+				}
+				job = slot->job;
+				RunJob(job, &result);
+				if (!alive()) {
+					// Job was failed by client, result is not needed
+					ret = 1;
+					break;
+				}
+				if (!WaitFor(header, channel.result_popped, -1, [&]() {
+					return TryPush(header->results, channel.results, capacity, result, channel.result_pushed,
+						&slot->push_pos);
+				})) {
+					break;
+				}
+				slot->has_job.store(0);
+				if (!alive()) {
+					ret = 1;
+					break;
+				}
+			}
+
+			// Release slot (unless client has taken it)
+			stop.store(true);
+			heartbeat.join();
+			uint32_t state = kSlotActive;
+			if (slot->generation.load() == generation && slot->state.compare_exchange_strong(state, kSlotClaiming)) {
+				slot->generation.fetch_add(1);
+				slot->state.store(kSlotFree);
+			}
+
+			CloseEvents(&channel);
+			UnmapChannel(&channel);
+			return ret;
+		}
+	}
+}
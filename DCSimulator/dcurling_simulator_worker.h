@@ -0,0 +1,58 @@
+#pragma once
+
+// Multi-process worker mode
+//  Jobs and results are exchanged through ring buffers in shared memory.
+//  Client creates a channel, then starts worker processes with
+//      DCSimulator worker <name>
+//  Up to kMaxWorkers workers can attach to one channel.
+//
+//  Workers send heartbeats, which the client checks in SubmitJob() / ReceiveResult().
+//  If a worker stops (e.g. crashes) for kWorkerLeaseMs, its job is failed and
+//  queue cells it was writing are released:
+//  ReceiveResult() returns it with steps = kWorkerLostSteps, the GameState before
+//  the shot and the shot without random number. Jobs are not retried.
+//  Each job gets exactly one result (a result which arrives after the job was
+//  failed is dropped), so a job can be reported as lost if its worker died just
+//  after pushing the result, or stalled longer than kWorkerLeaseMs.
+
+#include "dcurling_simulator.h"
+
+namespace digital_curling {
+
+	namespace b2simulator {
+
+		constexpr unsigned int kMaxWorkers = 64;     // Max num of workers attached to a channel
+		constexpr int kWorkerLeaseMs = 3000;         // Worker is taken as dead if its heartbeat stops for this time
+		constexpr int kWorkerLostSteps = -2;         // SimResult::steps of a job whose worker died
+
+		// Channel between a client and worker processes (opaque)
+		class WorkerChannel;
+
+		// Create channel in shared memory
+		//  name     : name of shared memory (alphanumeric)
+		//  capacity : num of jobs / results which can be queued (rounded up to power of 2)
+		//  returns nullptr if failed
+		DLLEXP WorkerChannel *CreateWorkerChannel(const char *name, unsigned int capacity);
+
+		// Stop workers and destroy channel
+		DLLEXP void DestroyWorkerChannel(WorkerChannel *channel);
+
+		// Push job to channel
+		//  job.id must be unique among jobs which are submitted and not received
+		//  timeout_ms : time to wait while queue is full (-1: infinite, 0: no wait)
+		//  returns false if timed out or job.id is in use
+		DLLEXP bool SubmitJob(WorkerChannel *channel, const SimJob &job, int timeout_ms);
+
+		// Pop result from channel (results may be out of order, use SimResult::id)
+		//  timeout_ms : time to wait while no result is ready (-1: infinite, 0: no wait)
+		//  returns false if timed out
+		DLLEXP bool ReceiveResult(WorkerChannel *channel, SimResult* const result, int timeout_ms);
+
+		// Main loop of worker process
+		//  Processes jobs in channel until DestroyWorkerChannel() is called
+		//  returns 0 if stopped normally, 1 if channel was not found
+		//  (or was not initialized within 10 seconds), kMaxWorkers workers are attached,
+		//  or client took this worker as dead
+		DLLEXP int RunWorker(const char *name);
+	}
+}
@@ -1,10 +1,15 @@
 //#include "Box2D/Box2D.h"
 #include "dcurling_simulator.h"
+#include "dcurling_simulator_worker.h"
+#include "dcurling_simulator_server.h"
+#include "dcurling_simulator_driver.h"
 
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <cstdlib>
+#include <cstring>
 
 using digital_curling::GameState;
 using digital_curling::ShotPos;
@@ -130,7 +135,75 @@ void random_test() {
 	cout << "Time spent = " << time_spent << endl;
 }
 
-int  main(void) {
+// Check that warmed-up simulations do not allocate heap memory in Box2D
+//  Runs the same ends twice (seeded) and fails if the second run allocates.
+//  returns 0 if succeeded
+int alloc_test(int num_ends) {
+	using namespace digital_curling;
+
+	int failures = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		int max_stack = 0, max_arena = 0;
+		for (int end = 0; end < num_ends; end++) {
+			GameState gs(8);
+			for (int shot = 0; shot < 16; shot++) {
+				SimJob job;
+				SimResult result;
+				job.game_state = gs;
+				job.seed = end * 16 + shot + 1;
+				job.random_x = job.random_y = 0.145f;
+				float x = kCenterX + 0.15f * ((shot * 7 + end) % 5 - 2);
+				float y = kTeeY + 0.4f * ((shot * 3 + end) % 7 - 3);
+				b2simulator::CreateShot(ShotPos(x, y, ((shot + end) & 1) != 0), &job.shot_vec);
+				if (shot % 4 == 3) {
+					job.shot_vec.y *= 1.15f;  // takeout
+				}
+				b2simulator::RunJob(job, &result);
+				gs = result.game_state;
+
+				SimStats stats;
+				b2simulator::GetLastSimStats(&stats);
+				if (stats.stack_bytes > max_stack) {
+					max_stack = stats.stack_bytes;
+				}
+				if (stats.arena_bytes > max_arena) {
+					max_arena = stats.arena_bytes;
+				}
+				if (pass == 1 && (stats.heap_allocations > 0 || stats.stack_fallbacks > 0)) {
+					cout << "alloc-test: end " << end << " shot " << shot << ": " <<
+						stats.heap_allocations << " heap allocations (" << stats.heap_bytes << " bytes), " <<
+						stats.stack_fallbacks << " stack fallbacks" << endl;
+					failures++;
+				}
+			}
+		}
+		cout << "alloc-test: " << (pass == 0 ? "warm-up" : "measured") <<
+			" max stack " << max_stack << " bytes, max arena " << max_arena << " bytes" << endl;
+	}
+	cout << "alloc-test: " << (failures == 0 ? "passed" : "FAILED") << endl;
+	return (failures == 0) ? 0 : 1;
+}
+
+int  main(int argc, char *argv[]) {
+
+	// Worker process for multi-process mode
+	if (argc >= 3 && strcmp(argv[1], "worker") == 0) {
+		return digital_curling::b2simulator::RunWorker(argv[2]);
+	}
+	// Local simulation server
+	if (argc >= 3 && strcmp(argv[1], "server") == 0) {
+		unsigned int num_threads = (argc >= 4) ? atoi(argv[3]) : 0;
+		return digital_curling::b2simulator::RunServer(argv[2], num_threads, 64) ? 0 : 1;
+	}
+	// Batch driver
+	if (argc >= 4 && strcmp(argv[1], "batch") == 0) {
+		unsigned int num_threads = (argc >= 5) ? atoi(argv[4]) : 0;
+		return digital_curling::b2simulator::RunBatchFile(argv[2], argv[3], num_threads, true);
+	}
+	// Allocation test (fails if warmed-up simulations allocate)
+	if (argc >= 2 && strcmp(argv[1], "alloc-test") == 0) {
+		return alloc_test((argc >= 3) ? atoi(argv[2]) : 8);
+	}
 
 	//operator_test();
 	//simuration_test();